@@ -0,0 +1,345 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cluon-complete.hpp"
+#include "opendlv-standard-message-set.hpp"
+
+#include "oxts-decoder.hpp"
+#include "oxts-forwarder.hpp"
+#include "oxts-kernels.hpp"
+#include "oxts-latency.hpp"
+#include "oxts-legacy.hpp"
+#include "oxts-ncom.hpp"
+#include "oxts-pipeline.hpp"
+#include "oxts-publisher.hpp"
+#include "oxts-receiver.hpp"
+#include "oxts-stages.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+using legacy::SAMPLE;
+
+// Keeps results alive so that the measured work is not optimized away.
+volatile double g_sink{0.0};
+
+struct Result {
+    std::string name{};
+    // Unit of one operation, e.g. packet or message.
+    std::string unit{};
+    uint64_t operations{0};
+    std::chrono::nanoseconds elapsed{0};
+};
+
+// Runs benchmark(iterations) after a warm-up of a tenth of the iterations; benchmark returns the number of operations.
+template <typename BENCHMARK>
+Result measure(const std::string &name, const std::string &unit, uint64_t iterations, BENCHMARK &&benchmark) {
+    benchmark(iterations / 10 + 1);
+    const std::chrono::steady_clock::time_point START{std::chrono::steady_clock::now()};
+    const uint64_t OPERATIONS{benchmark(iterations)};
+    Result result;
+    result.name       = name;
+    result.unit       = unit;
+    result.operations = OPERATIONS;
+    result.elapsed    = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - START);
+    return result;
+}
+
+template <typename T>
+uint64_t serializeLikeOD4Session(T &message, uint64_t iterations) {
+    const cluon::data::TimeStamp SAMPLE_TIME{cluon::time::now()};
+    uint64_t bytes{0};
+    for (uint64_t i{0}; i < iterations; i++) {
+        // Same steps as cluon::OD4Session::send().
+        cluon::ToProtoVisitor protoEncoder;
+        cluon::data::Envelope envelope;
+        envelope.dataType(static_cast<int32_t>(message.ID()));
+        message.accept(protoEncoder);
+        envelope.serializedData(protoEncoder.encodedData());
+        envelope.sent(cluon::time::now());
+        envelope.sampleTimeStamp(SAMPLE_TIME);
+        bytes += cluon::OD4Session::serializeAsOD4Container(std::move(envelope)).size();
+    }
+    g_sink = g_sink + static_cast<double>(bytes);
+    return iterations;
+}
+
+template <typename T>
+uint64_t serializeWithPublisher(od4::Publisher &publisher, const T &message, uint64_t iterations) {
+    const cluon::data::TimeStamp SAMPLE_TIME{cluon::time::now()};
+    uint64_t bytes{0};
+    for (uint64_t i{0}; i < iterations; i++) {
+        bytes += publisher.serialize(message, SAMPLE_TIME, cluon::time::now(), 0).second;
+    }
+    g_sink = g_sink + static_cast<double>(bytes);
+    return iterations;
+}
+
+struct EndToEnd {
+    uint64_t sent{0};
+    uint64_t published{0};
+    // Messages of the published position as received back from the OD4 session.
+    uint64_t received{0};
+    uint64_t dropped{0};
+    std::chrono::nanoseconds elapsed{0};
+    std::chrono::nanoseconds p50{0};
+    std::chrono::nanoseconds p99{0};
+    std::chrono::nanoseconds max{0};
+};
+
+// Sends packets over the loopback interface into the same receiver, pipeline, and forwarder as oxts.
+EndToEnd endToEnd(uint16_t port, uint16_t cid, uint64_t packets) {
+    EndToEnd result;
+    std::atomic<uint64_t> received{0};
+    cluon::OD4Session od4{cid, [&received](cluon::data::Envelope &&envelope) {
+        if (static_cast<int32_t>(opendlv::proxy::GeodeticWgs84Reading::ID()) == envelope.dataType()) {
+            received++;
+        }
+    }};
+    od4::Publisher publisher{cid};
+    OxTSDecoder decoder;
+    OxTSForwarder forwarder{publisher, od4, 0};
+    LatencyHistogram socketToPublish;
+    std::atomic<uint64_t> published{0};
+
+    OxTSPipeline pipeline(spsc::Overflow::BLOCK,
+        [&](uint32_t, const uint8_t *data, std::size_t length, const std::chrono::system_clock::time_point &tp) noexcept {
+        OxTSDecoder::Readings readings;
+        decoder.decode(data, length, readings);
+        const std::chrono::system_clock::time_point NOW{std::chrono::system_clock::now()};
+        if (forwarder.forward(readings, decoder.status(), cluon::time::convert(tp), NOW)) {
+            socketToPublish.record(std::chrono::system_clock::now() - tp);
+        }
+        published.store(published.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    });
+    OxTSReceiver receiver("127.0.0.1", port,
+        [&queue = pipeline](const uint8_t *data, std::size_t length, const std::chrono::system_clock::time_point &tp) noexcept {
+        queue.push(0, data, length, tp);
+    });
+
+    const int SOCKET{::socket(AF_INET, SOCK_DGRAM, 0)};
+    if (0 > SOCKET) {
+        return result;
+    }
+    struct sockaddr_in address {};
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    // At most WINDOW packets are in flight so that the socket buffer does not overflow.
+    constexpr uint64_t WINDOW{256};
+    const std::chrono::steady_clock::time_point START{std::chrono::steady_clock::now()};
+    const std::chrono::steady_clock::time_point TIMEOUT{START + std::chrono::seconds{30}};
+    for (uint64_t i{0}; (i < packets) && (std::chrono::steady_clock::now() < TIMEOUT); i++) {
+        while ( (published.load(std::memory_order_acquire) + WINDOW <= i) && (std::chrono::steady_clock::now() < TIMEOUT) ) {
+            std::this_thread::yield();
+        }
+        if (static_cast<ssize_t>(SAMPLE.size()) == ::sendto(SOCKET, SAMPLE.data(), SAMPLE.size(), 0, reinterpret_cast<struct sockaddr *>(&address), sizeof(address))) {
+            result.sent++;
+        }
+    }
+    while ( (published.load(std::memory_order_acquire) < result.sent) && (std::chrono::steady_clock::now() < TIMEOUT) ) {
+        std::this_thread::yield();
+    }
+    result.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - START);
+    ::close(SOCKET);
+
+    // Multicast loopback is delivered asynchronously.
+    std::this_thread::sleep_for(std::chrono::milliseconds{200});
+    result.published = published.load();
+    result.received  = received.load();
+    result.dropped   = pipeline.statistics().dropped.load();
+    result.p50       = socketToPublish.percentile(50.0);
+    result.p99       = socketToPublish.percentile(99.0);
+    result.max       = socketToPublish.max();
+    return result;
+}
+
+const char *kernelName(ncom::Kernel kernel) noexcept {
+    switch (kernel) {
+        case ncom::Kernel::SSE2: return "sse2";
+        case ncom::Kernel::AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+std::string toJson(const std::vector<Result> &results, const EndToEnd *e2e) {
+    std::stringstream json;
+    json << std::fixed << std::setprecision(1);
+    json << "{\n  \"kernel\": \"" << kernelName(ncom::bestKernel()) << "\",\n  \"benchmarks\": [";
+    for (std::size_t i{0}; i < results.size(); i++) {
+        const Result &r = results[i];
+        const double NS{static_cast<double>(r.elapsed.count())};
+        const double OPERATIONS{static_cast<double>(r.operations)};
+        json << ((0 == i) ? "\n" : ",\n")
+             << "    {\"name\": \"" << r.name << "\", \"unit\": \"" << r.unit << "\", \"operations\": " << r.operations
+             << ", \"ns_per_" << r.unit << "\": " << ((0 < r.operations) ? NS / OPERATIONS : 0.0)
+             << ", \"" << r.unit << "s_per_s\": " << ((0.0 < NS) ? OPERATIONS * 1e9 / NS : 0.0) << "}";
+    }
+    json << "\n  ]";
+    if (nullptr != e2e) {
+        const double NS{static_cast<double>(e2e->elapsed.count())};
+        json << ",\n  \"end_to_end\": {\"sent\": " << e2e->sent << ", \"published\": " << e2e->published
+             << ", \"received\": " << e2e->received << ", \"dropped\": " << e2e->dropped
+             << ", \"ns_per_packet\": " << ((0 < e2e->published) ? NS / static_cast<double>(e2e->published) : 0.0)
+             << ", \"packets_per_s\": " << ((0.0 < NS) ? static_cast<double>(e2e->published) * 1e9 / NS : 0.0)
+             << ", \"latency_ns\": {\"p50\": " << e2e->p50.count() << ", \"p99\": " << e2e->p99.count() << ", \"max\": " << e2e->max.count() << "}}";
+    }
+    json << "\n}\n";
+    return json.str();
+}
+} // namespace
+
+int32_t main(int32_t argc, char **argv) {
+    int32_t retCode{0};
+    const std::string PROGRAM(argv[0]);
+    argh::parser commandline(argc, argv);
+
+    if (commandline[{"-h", "--help"}]) {
+        std::cerr << PROGRAM << " measures decoding, serialization, and the end-to-end path from UDP to the OpenDaVINCI session and prints the results as JSON." << std::endl;
+        std::cerr << "Usage:   " << PROGRAM << " [--iterations=<n>] [--packets=<n>] [--port=<port>] [--cid=<OpenDaVINCI session>] [--out=<file>]" << std::endl;
+        std::cerr << "         --iterations: operations per microbenchmark (default: 1000000)" << std::endl;
+        std::cerr << "         --packets:    packets sent through the loopback interface; 0 skips the end-to-end run (default: 20000)" << std::endl;
+        std::cerr << "         --port:       UDP port for the end-to-end run (default: 39000)" << std::endl;
+        std::cerr << "         --cid:        OpenDaVINCI session for the end-to-end run (default: 253)" << std::endl;
+        std::cerr << "         --out:        file to write the JSON to (default: standard output)" << std::endl;
+        std::cerr << "Example: " << PROGRAM << " --iterations=100000 --out=bench.json" << std::endl;
+        retCode = 1;
+    } else {
+        uint64_t iterations{1000000};
+        commandline("iterations", iterations) >> iterations;
+        uint64_t packets{20000};
+        commandline("packets", packets) >> packets;
+        uint16_t port{39000};
+        commandline("port", port) >> port;
+        uint16_t cid{253};
+        commandline("cid", cid) >> cid;
+
+        std::vector<Result> results;
+        results.push_back(measure("decode_stream", "packet", iterations / 10, [](uint64_t n) {
+            const std::string DATA(reinterpret_cast<const char *>(SAMPLE.data()), SAMPLE.size());
+            double sum{0.0};
+            for (uint64_t i{0}; i < n; i++) {
+                const legacy::Readings READINGS{legacy::decode(DATA)};
+                sum += READINGS.latitude + READINGS.longitude + static_cast<double>(READINGS.northHeading);
+            }
+            g_sink = g_sink + sum;
+            return n;
+        }));
+        results.push_back(measure("decode", "packet", iterations, [](uint64_t n) {
+            OxTSDecoder decoder;
+            OxTSDecoder::Readings readings;
+            double sum{0.0};
+            for (uint64_t i{0}; i < n; i++) {
+                decoder.decode(SAMPLE.data(), SAMPLE.size(), readings);
+                sum += readings.position.latitude();
+            }
+            g_sink = g_sink + sum;
+            return n;
+        }));
+
+        constexpr std::size_t BATCH{1024};
+        std::vector<uint8_t> batch;
+        for (std::size_t i{0}; i < BATCH; i++) {
+            batch.insert(batch.end(), SAMPLE.begin(), SAMPLE.end());
+        }
+        results.push_back(measure("decode_batch", "packet", iterations, [&batch](uint64_t n) {
+            OxTSDecoder decoder;
+            std::vector<double> latitude(BATCH);
+            std::vector<double> longitude(BATCH);
+            std::vector<float> northHeading(BATCH);
+            OxTSDecoder::Columns columns;
+            columns.latitude     = latitude.data();
+            columns.longitude    = longitude.data();
+            columns.northHeading = northHeading.data();
+            uint64_t decoded{0};
+            for (uint64_t i{0}; i < (n + BATCH - 1) / BATCH; i++) {
+                decoded += decoder.decodeBatch(batch.data(), BATCH, columns);
+            }
+            g_sink = g_sink + latitude[0];
+            return decoded;
+        }));
+
+        OxTSDecoder decoder;
+        OxTSDecoder::Readings readings;
+        decoder.decode(SAMPLE.data(), SAMPLE.size(), readings);
+        results.push_back(measure("serialize_position_od4session", "message", iterations / 10, [&readings](uint64_t n) {
+            return serializeLikeOD4Session(readings.position, n);
+        }));
+        results.push_back(measure("serialize_heading_od4session", "message", iterations / 10, [&readings](uint64_t n) {
+            return serializeLikeOD4Session(readings.heading, n);
+        }));
+        od4::Publisher publisher{cid};
+        results.push_back(measure("serialize_position_publisher", "message", iterations, [&publisher, &readings](uint64_t n) {
+            return serializeWithPublisher(publisher, readings.position, n);
+        }));
+        results.push_back(measure("serialize_heading_publisher", "message", iterations, [&publisher, &readings](uint64_t n) {
+            return serializeWithPublisher(publisher, readings.heading, n);
+        }));
+
+        // Cost of the instrumentation per packet: the total for every packet, and four time points and four more histograms for sampled ones.
+        stages::Latencies latencies;
+        results.push_back(measure("stage_timing", "packet", iterations, [&latencies](uint64_t n) {
+            stages::Marks marks;
+            for (uint64_t i{0}; i < n; i++) {
+                if (latencies.begin(marks)) {
+                    marks.decodeEnd    = stages::now();
+                    marks.serializeEnd = stages::now();
+                    marks.sendEnd      = stages::now();
+                }
+                latencies.record(marks, std::chrono::nanoseconds{static_cast<int64_t>(i & 0xFFFF)});
+            }
+            return n;
+        }));
+
+        EndToEnd e2e;
+        if (0 < packets) {
+            e2e = endToEnd(port, cid, packets);
+            if (e2e.published < e2e.sent) {
+                std::cerr << "[oxts-bench] Only " << e2e.published << " of " << e2e.sent << " packets were published." << std::endl;
+                retCode = 1;
+            }
+        }
+
+        const std::string JSON{toJson(results, (0 < packets) ? &e2e : nullptr)};
+        if (commandline("out")) {
+            std::ofstream out(commandline("out").str(), std::ios::out | std::ios::trunc);
+            out << JSON;
+            if (!out.good()) {
+                std::cerr << "[oxts-bench] Failed to write " << commandline("out").str() << std::endl;
+                retCode = 1;
+            }
+        } else {
+            std::cout << JSON;
+        }
+    }
+    return retCode;
+}
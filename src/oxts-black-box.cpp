@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "oxts-black-box.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+namespace {
+// Sequence numbers skip 0, which marks records that are empty or being written.
+uint32_t successor(uint32_t sequence) noexcept {
+    return (std::numeric_limits<uint32_t>::max() == sequence) ? 1 : sequence + 1;
+}
+
+// @return Index of the newest record, i.e. the one not followed by its successor, or capacity for an empty ring.
+std::size_t newest(const blackbox::Record *records, std::size_t capacity) noexcept {
+    for (std::size_t i{0}; i < capacity; i++) {
+        const uint32_t SEQUENCE{records[i].sequence};
+        if ( (0 != SEQUENCE) && (successor(SEQUENCE) != records[(i + 1) % capacity].sequence) ) {
+            return i;
+        }
+    }
+    return capacity;
+}
+
+// @return true if header describes a ring file of the given size.
+bool isValid(const blackbox::Header &header, std::size_t size) noexcept {
+    return (blackbox::HEADER_SIZE <= size)
+           && (blackbox::MAGIC == header.magic)
+           && (blackbox::VERSION == header.version)
+           && (sizeof(blackbox::Record) == header.recordSize)
+           && (0 < header.capacity)
+           && (header.capacity <= (size - blackbox::HEADER_SIZE) / sizeof(blackbox::Record));
+}
+
+bool readHeader(const uint8_t *data, std::size_t size, blackbox::Header &header) noexcept {
+    if ( (nullptr == data) || (size < blackbox::HEADER_SIZE) ) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    return isValid(header, size);
+}
+} // namespace
+
+OxTSBlackBox::OxTSBlackBox(const std::string &path, std::size_t capacity) noexcept
+    : m_capacity(capacity) {
+    const std::size_t SIZE{blackbox::HEADER_SIZE + capacity * sizeof(blackbox::Record)};
+    const int FD{::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)};
+    if (FD < 0) {
+        std::cerr << "[OxTSBlackBox] Failed to open " << path << ": " << ::strerror(errno) << std::endl;
+        return;
+    }
+
+    // An existing ring of the same capacity is continued; anything else is cleared.
+    bool isRing{false};
+    {
+        struct stat info {};
+        blackbox::Header header{};
+        isRing = (0 == ::fstat(FD, &info)) && (static_cast<std::size_t>(info.st_size) == SIZE)
+                 && (static_cast<ssize_t>(sizeof(header)) == ::pread(FD, &header, sizeof(header), 0))
+                 && isValid(header, SIZE)
+                 && (capacity == header.capacity);
+    }
+    if (!isRing && (0 != ::ftruncate(FD, 0))) {
+        std::cerr << "[OxTSBlackBox] Failed to clear " << path << ": " << ::strerror(errno) << std::endl;
+        ::close(FD);
+        return;
+    }
+
+    // Allocating all blocks upfront avoids SIGBUS on a full disk while recording.
+    const int ERROR{(0 == capacity) ? EINVAL : ::posix_fallocate(FD, 0, static_cast<off_t>(SIZE))};
+    if (0 != ERROR) {
+        std::cerr << "[OxTSBlackBox] Failed to allocate " << SIZE << " bytes for " << path << ": " << ::strerror(ERROR) << std::endl;
+        ::close(FD);
+        return;
+    }
+    // Prefaulting the pages keeps page faults out of the receiving thread.
+    void *mapping = ::mmap(nullptr, SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, FD, 0);
+    ::close(FD);
+    if (MAP_FAILED == mapping) {
+        std::cerr << "[OxTSBlackBox] Failed to map " << path << ": " << ::strerror(errno) << std::endl;
+        return;
+    }
+    m_mapping    = mapping;
+    m_mappedSize = SIZE;
+    m_records    = reinterpret_cast<blackbox::Record *>(static_cast<uint8_t *>(mapping) + blackbox::HEADER_SIZE);
+
+    if (isRing) {
+        const std::size_t NEWEST{newest(m_records, m_capacity)};
+        if (NEWEST < m_capacity) {
+            m_next     = (NEWEST + 1) % m_capacity;
+            m_sequence = m_records[NEWEST].sequence;
+        }
+    } else {
+        blackbox::Header header{};
+        header.magic      = blackbox::MAGIC;
+        header.version    = blackbox::VERSION;
+        header.recordSize = sizeof(blackbox::Record);
+        header.capacity   = m_capacity;
+        std::memcpy(mapping, &header, sizeof(header));
+    }
+}
+
+OxTSBlackBox::~OxTSBlackBox() noexcept {
+    if (nullptr != m_mapping) {
+        ::munmap(m_mapping, m_mappedSize);
+    }
+}
+
+bool OxTSBlackBox::isOpen() const noexcept {
+    return nullptr != m_mapping;
+}
+
+void OxTSBlackBox::record(uint32_t unit, const uint8_t *data, std::size_t length, const std::chrono::system_clock::time_point &tp) noexcept {
+    if (nullptr == m_records) {
+        return;
+    }
+    blackbox::Record &record = m_records[m_next];
+    // Invalidate first so that a crash while copying leaves no torn record behind.
+    record.sequence = 0;
+    std::atomic_signal_fence(std::memory_order_release);
+
+    record.received = std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+    record.unit     = static_cast<uint16_t>(unit);
+    record.length   = static_cast<uint16_t>(std::min<std::size_t>(length, std::numeric_limits<uint16_t>::max()));
+    const std::size_t LENGTH{std::min(length, record.packet.size())};
+    std::memcpy(record.packet.data(), data, LENGTH);
+    std::memset(record.packet.data() + LENGTH, 0, record.packet.size() - LENGTH);
+
+    std::atomic_signal_fence(std::memory_order_release);
+    m_sequence      = successor(m_sequence);
+    record.sequence = m_sequence;
+    m_next          = (m_next + 1) % m_capacity;
+}
+
+bool OxTSBlackBox::isRingFile(const uint8_t *data, std::size_t size) noexcept {
+    blackbox::Header header{};
+    return readHeader(data, size, header);
+}
+
+std::vector<const blackbox::Record *> OxTSBlackBox::chronological(const uint8_t *data, std::size_t size) {
+    std::vector<const blackbox::Record *> retVal;
+    blackbox::Header header{};
+    if (readHeader(data, size, header)) {
+        const blackbox::Record *records{reinterpret_cast<const blackbox::Record *>(data + blackbox::HEADER_SIZE)};
+        const std::size_t CAPACITY{static_cast<std::size_t>(header.capacity)};
+        const std::size_t NEWEST{newest(records, CAPACITY)};
+        if (NEWEST < CAPACITY) {
+            retVal.reserve(CAPACITY);
+            for (std::size_t i{1}; i <= CAPACITY; i++) {
+                const blackbox::Record &record = records[(NEWEST + i) % CAPACITY];
+                if (0 != record.sequence) {
+                    retVal.push_back(&record);
+                }
+            }
+        }
+    }
+    return retVal;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_BLACK_BOX
+#define OXTS_BLACK_BOX
+
+#include "oxts-ncom.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace blackbox {
+constexpr std::array<char, 8> MAGIC{{'O', 'X', 'T', 'S', 'R', 'I', 'N', 'G'}};
+constexpr uint32_t VERSION{1};
+
+// Written once when the file is created; the remainder of the first 64 bytes is reserved.
+struct Header {
+    std::array<char, 8> magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t capacity;
+};
+constexpr std::size_t HEADER_SIZE{64};
+static_assert(sizeof(Header) <= HEADER_SIZE, "Header must fit into its reserved space.");
+
+// One datagram: 16 bytes of metadata followed by the packet.
+struct Record {
+    int64_t received;  // Kernel receive time [ns since epoch].
+    uint32_t sequence; // Counts from 1; 0 marks an empty or partially written record.
+    uint16_t unit;
+    uint16_t length;   // Received length; longer datagrams are truncated to the packet.
+    std::array<uint8_t, ncom::PACKET_LENGTH> packet;
+};
+static_assert(16 + ncom::PACKET_LENGTH == sizeof(Record), "Records must not be padded.");
+} // namespace blackbox
+
+/**
+ * Black-box recorder keeping the most recent datagrams in a ring file: The
+ * file is preallocated and mapped shared when opening so that recording
+ * copies a fixed-size record into the page cache without any system call.
+ * The kernel writes the pages back on its own, so the ring survives a
+ * crash of this process (but not of the machine without a sync).
+ *
+ * Not thread-safe: record() is meant to be called from the receiving thread.
+ */
+class OxTSBlackBox {
+   private:
+    OxTSBlackBox(const OxTSBlackBox &) = delete;
+    OxTSBlackBox(OxTSBlackBox &&)      = delete;
+    OxTSBlackBox &operator=(const OxTSBlackBox &) = delete;
+    OxTSBlackBox &operator=(OxTSBlackBox &&) = delete;
+
+   public:
+    /**
+     * Constructor; an existing ring of the same capacity is continued after
+     * its newest record, any other file is overwritten.
+     *
+     * @param path File to record into.
+     * @param capacity Number of records to keep.
+     */
+    OxTSBlackBox(const std::string &path, std::size_t capacity) noexcept;
+    ~OxTSBlackBox() noexcept;
+
+    /**
+     * @return true if the file could be preallocated and mapped.
+     */
+    bool isOpen() const noexcept;
+
+    /**
+     * This method records a datagram by overwriting the oldest record.
+     *
+     * @param unit Index of the unit that sent the datagram.
+     * @param data Received bytes.
+     * @param length Number of received bytes.
+     * @param tp Kernel receive time.
+     */
+    void record(uint32_t unit, const uint8_t *data, std::size_t length, const std::chrono::system_clock::time_point &tp) noexcept;
+
+    /**
+     * @param data Mapped file.
+     * @param size Size of the mapped file.
+     * @return true if the data starts with a ring file's header.
+     */
+    static bool isRingFile(const uint8_t *data, std::size_t size) noexcept;
+
+    /**
+     * @param data Mapped ring file.
+     * @param size Size of the mapped file.
+     * @return Complete records from the oldest to the newest one.
+     */
+    static std::vector<const blackbox::Record *> chronological(const uint8_t *data, std::size_t size);
+
+   private:
+    void *m_mapping{nullptr};
+    std::size_t m_mappedSize{0};
+    blackbox::Record *m_records{nullptr};
+    std::size_t m_capacity{0};
+    std::size_t m_next{0};
+    uint32_t m_sequence{0};
+};
+
+#endif
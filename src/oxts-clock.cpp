@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "oxts-clock.hpp"
+#include "oxts-counters.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+using counters::increment;
+
+template <typename T, std::size_t N>
+T median(std::array<T, N> &values, std::size_t count) noexcept {
+    auto middle = values.begin() + static_cast<std::ptrdiff_t>(count / 2);
+    std::nth_element(values.begin(), middle, values.begin() + static_cast<std::ptrdiff_t>(count));
+    return *middle;
+}
+} // namespace
+
+constexpr std::size_t ClockOffsetEstimator::WINDOW;
+constexpr std::chrono::milliseconds ClockOffsetEstimator::STEP;
+constexpr std::chrono::milliseconds ClockOffsetEstimator::HORIZON;
+
+ClockOffsetEstimator::ClockOffsetEstimator(std::chrono::milliseconds horizon) noexcept
+    : m_horizon(std::chrono::duration_cast<std::chrono::nanoseconds>(horizon).count()) {}
+
+void ClockOffsetEstimator::add(std::chrono::nanoseconds gpsTime, std::chrono::system_clock::time_point received) noexcept {
+    const int64_t GPS_TIME{gpsTime.count()};
+    const int64_t RESIDUAL{std::chrono::duration_cast<std::chrono::nanoseconds>(received.time_since_epoch()).count() - GPS_TIME};
+
+    if (0 < m_count) {
+        if (GPS_TIME < m_previousGpsTime - m_horizon) {
+            // The unit's time jumped backwards, e.g., after a restart.
+            reset();
+        } else if (GPS_TIME < m_previousGpsTime) {
+            // Reordered packet; its delay says nothing about the offset.
+            increment(m_health.late);
+            return;
+        } else if (GPS_TIME == m_previousGpsTime) {
+            // Duplicated packet.
+            return;
+        }
+    }
+    if (m_isLocked) {
+        const int64_t DELAY{RESIDUAL - predict(GPS_TIME)};
+        m_health.residual.store(DELAY, std::memory_order_relaxed);
+        if (DELAY < -std::chrono::duration_cast<std::chrono::nanoseconds>(STEP).count()) {
+            // Received before it was sent: system_clock was stepped.
+            reset();
+        }
+    }
+    m_previousGpsTime = GPS_TIME;
+    if (0 == m_count) {
+        m_base = RESIDUAL;
+    }
+
+    m_gpsTimes[m_next]  = GPS_TIME;
+    m_residuals[m_next] = RESIDUAL;
+    m_next              = (m_next + 1) % WINDOW;
+    m_count             = std::min(m_count + 1, WINDOW);
+    increment(m_health.samples);
+
+    m_sinceFit++;
+    if ( (MIN_SAMPLES <= m_count) && (!m_isLocked || (REFIT <= m_sinceFit)) ) {
+        fit();
+    }
+}
+
+std::chrono::system_clock::time_point ClockOffsetEstimator::toSystemClock(std::chrono::nanoseconds gpsTime) const noexcept {
+    const std::chrono::nanoseconds SYSTEM_TIME{gpsTime.count() + predict(gpsTime.count())};
+    return std::chrono::system_clock::time_point{std::chrono::duration_cast<std::chrono::system_clock::duration>(SYSTEM_TIME)};
+}
+
+bool ClockOffsetEstimator::isLocked() const noexcept {
+    return m_isLocked;
+}
+
+const ClockOffsetEstimator::Health &ClockOffsetEstimator::health() const noexcept {
+    return m_health;
+}
+
+int64_t ClockOffsetEstimator::predict(int64_t gpsTime) const noexcept {
+    return m_base + static_cast<int64_t>(std::llround(m_intercept + m_slope * static_cast<double>(gpsTime - m_reference)));
+}
+
+void ClockOffsetEstimator::reset() noexcept {
+    m_next     = 0;
+    m_count    = 0;
+    m_sinceFit = 0;
+    m_isLocked = false;
+    increment(m_health.resets);
+    m_health.isLocked.store(false, std::memory_order_relaxed);
+}
+
+void ClockOffsetEstimator::fit() noexcept {
+    m_sinceFit = 0;
+    const std::size_t OLDEST{(m_next + WINDOW - m_count) % WINDOW};
+    const int64_t REFERENCE{m_gpsTimes[(m_next + WINDOW - 1) % WINDOW]};
+
+    // Lower envelope: the earliest reception per segment of the window.
+    std::array<double, SEGMENTS> x;
+    std::array<double, SEGMENTS> y;
+    const std::size_t SEGMENT_LENGTH{m_count / SEGMENTS};
+    for (std::size_t s{0}; s < SEGMENTS; s++) {
+        const std::size_t END{(SEGMENTS - 1 == s) ? m_count : (s + 1) * SEGMENT_LENGTH};
+        std::size_t best{(OLDEST + s * SEGMENT_LENGTH) % WINDOW};
+        for (std::size_t i{s * SEGMENT_LENGTH + 1}; i < END; i++) {
+            const std::size_t INDEX{(OLDEST + i) % WINDOW};
+            best = (m_residuals[INDEX] < m_residuals[best]) ? INDEX : best;
+        }
+        x[s] = static_cast<double>(m_gpsTimes[best] - REFERENCE);
+        y[s] = static_cast<double>(m_residuals[best] - m_base);
+    }
+
+    // Theil-Sen: median of the pairwise slopes, then median of the intercepts.
+    std::array<double, SEGMENTS * (SEGMENTS - 1) / 2> slopes;
+    std::size_t pairs{0};
+    for (std::size_t i{0}; i < SEGMENTS; i++) {
+        for (std::size_t j{i + 1}; j < SEGMENTS; j++) {
+            if (x[j] > x[i]) {
+                slopes[pairs++] = (y[j] - y[i]) / (x[j] - x[i]);
+            }
+        }
+    }
+    const double SLOPE{(0 < pairs) ? median(slopes, pairs) : 0.0};
+    std::array<double, SEGMENTS> intercepts;
+    for (std::size_t s{0}; s < SEGMENTS; s++) {
+        intercepts[s] = y[s] - SLOPE * x[s];
+    }
+    m_reference = REFERENCE;
+    m_slope     = SLOPE;
+    m_intercept = median(intercepts, SEGMENTS);
+    m_isLocked  = true;
+
+    // Residuals of the whole window to the new fit.
+    std::array<int64_t, WINDOW> residuals;
+    int64_t maxResidual{0};
+    for (std::size_t i{0}; i < m_count; i++) {
+        const std::size_t INDEX{(OLDEST + i) % WINDOW};
+        residuals[i] = m_residuals[INDEX] - predict(m_gpsTimes[INDEX]);
+        maxResidual  = std::max(maxResidual, residuals[i]);
+    }
+
+    m_health.offset.store(predict(REFERENCE), std::memory_order_relaxed);
+    m_health.drift.store(m_slope * 1e6, std::memory_order_relaxed);
+    m_health.medianResidual.store(median(residuals, m_count), std::memory_order_relaxed);
+    m_health.maxResidual.store(maxResidual, std::memory_order_relaxed);
+    m_health.isLocked.store(true, std::memory_order_relaxed);
+}
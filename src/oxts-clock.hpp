@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_CLOCK
+#define OXTS_CLOCK
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Online estimator mapping a unit's GPS time to the local system_clock.
+ *
+ * The receive time of a packet is its GPS time plus the clock offset plus a
+ * non-negative transport delay. The estimator fits offset and drift to the
+ * lower envelope of recent (GPS time, receive time - GPS time) pairs using
+ * the Theil-Sen estimator (median of pairwise slopes), which ignores
+ * delayed packets and outliers. The mapped time stamps are therefore free
+ * of network and scheduling jitter.
+ *
+ * add() and toSystemClock() are meant to be called from a single thread;
+ * health() may be read concurrently.
+ */
+class ClockOffsetEstimator {
+   private:
+    ClockOffsetEstimator(const ClockOffsetEstimator &) = delete;
+    ClockOffsetEstimator(ClockOffsetEstimator &&)      = delete;
+    ClockOffsetEstimator &operator=(const ClockOffsetEstimator &) = delete;
+    ClockOffsetEstimator &operator=(ClockOffsetEstimator &&) = delete;
+
+   public:
+    // Number of recent samples the fit is based on.
+    static constexpr std::size_t WINDOW{512};
+    // The window is split into SEGMENTS whose earliest receptions form the lower envelope.
+    static constexpr std::size_t SEGMENTS{8};
+    // Samples needed before time stamps are mapped.
+    static constexpr std::size_t MIN_SAMPLES{2 * SEGMENTS};
+    // Number of samples between two fits.
+    static constexpr std::size_t REFIT{16};
+    // A sample received this much earlier than predicted indicates a clock step.
+    static constexpr std::chrono::milliseconds STEP{5};
+    // Default span of late packets, e.g. reordered on the network: 64 packets at 100 Hz.
+    static constexpr std::chrono::milliseconds HORIZON{640};
+
+    /**
+     * Residuals of the received samples to the fit; they are the transport
+     * delays beyond the fastest packets and indicate the timing health.
+     */
+    struct Health {
+        std::atomic<uint64_t> samples{0};
+        // Number of times the window was restarted due to clock steps or GPS time jumps.
+        std::atomic<uint64_t> resets{0};
+        // Samples older than the newest one within the horizon; they are skipped.
+        std::atomic<uint64_t> late{0};
+        std::atomic<bool> isLocked{false};
+        // Receive time - GPS time as of the last fit [ns].
+        std::atomic<int64_t> offset{0};
+        // Drift of system_clock relative to GPS time [ppm].
+        std::atomic<double> drift{0.0};
+        // Residual of the latest sample [ns].
+        std::atomic<int64_t> residual{0};
+        // Median and largest residual within the window as of the last fit [ns].
+        std::atomic<int64_t> medianResidual{0};
+        std::atomic<int64_t> maxResidual{0};
+    };
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param horizon Samples up to this much older than the newest one are
+     *        late packets and skipped; older ones indicate that the unit's
+     *        time jumped back and restart the estimation.
+     */
+    explicit ClockOffsetEstimator(std::chrono::milliseconds horizon = HORIZON) noexcept;
+
+    /**
+     * This method adds a sample and refits if needed.
+     *
+     * @param gpsTime Time since the GPS epoch from the packet.
+     * @param received Time when the packet was received.
+     */
+    void add(std::chrono::nanoseconds gpsTime, std::chrono::system_clock::time_point received) noexcept;
+
+    /**
+     * @param gpsTime Time since the GPS epoch.
+     * @return Corresponding time point of system_clock; undefined unless isLocked().
+     */
+    std::chrono::system_clock::time_point toSystemClock(std::chrono::nanoseconds gpsTime) const noexcept;
+
+    /**
+     * @return true if enough samples were collected to map time stamps.
+     */
+    bool isLocked() const noexcept;
+
+    const Health &health() const noexcept;
+
+   private:
+    void fit() noexcept;
+    void reset() noexcept;
+    int64_t predict(int64_t gpsTime) const noexcept;
+
+   private:
+    // Samples in a ring; residual is receive time - GPS time [ns].
+    std::array<int64_t, WINDOW> m_gpsTimes{};
+    std::array<int64_t, WINDOW> m_residuals{};
+    std::size_t m_next{0};
+    std::size_t m_count{0};
+    std::size_t m_sinceFit{0};
+    int64_t m_previousGpsTime{0};
+    const int64_t m_horizon;
+    // First residual of the window; keeps the fit's doubles small enough for nanoseconds.
+    int64_t m_base{0};
+
+    // Model: residual = m_base + m_intercept + m_slope * (gpsTime - m_reference).
+    bool m_isLocked{false};
+    int64_t m_reference{0};
+    double m_intercept{0.0};
+    double m_slope{0.0};
+
+    Health m_health{};
+};
+
+#endif
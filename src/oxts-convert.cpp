@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cluon-complete.hpp"
+
+#include "oxts-converter.hpp"
+#include "oxts-recording.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+// @return true if all bytes were written to the file descriptor.
+bool writeAll(int fd, const char *data, std::size_t length) noexcept {
+    while (0 < length) {
+        const ssize_t WRITTEN{::write(fd, data, length)};
+        if (0 > WRITTEN) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return false;
+        }
+        data += WRITTEN;
+        length -= static_cast<std::size_t>(WRITTEN);
+    }
+    return true;
+}
+} // namespace
+
+int32_t main(int32_t argc, char **argv) {
+    int32_t retCode{0};
+    const std::string PROGRAM(argv[0]);
+    argh::parser commandline(argc, argv);
+
+    const std::string FORMAT{commandline("format", "csv").str()};
+    if ( (2 != commandline.pos_args().size()) || (("csv" != FORMAT) && ("json" != FORMAT)) ) {
+        std::cerr << PROGRAM << " converts a recorded NCOM file (the raw packets as sent by an OXTS GPS/INSS unit) into CSV or JSON Lines using all cores." << std::endl;
+        std::cerr << "Usage:   " << PROGRAM << " <file.ncom> [--format=csv|json] [--out=<file>] [--threads=<n>]" << std::endl;
+        std::cerr << "         --format:  one line per packet as CSV with header (default) or as JSON object" << std::endl;
+        std::cerr << "         --out:     file to write to (default: standard output)" << std::endl;
+        std::cerr << "         --threads: number of converting threads (default: " << std::thread::hardware_concurrency() << ")" << std::endl;
+        std::cerr << "Example: " << PROGRAM << " drive.ncom --format=json --out=drive.json" << std::endl;
+        retCode = 1;
+    } else {
+        OxTSRecording recording{commandline[1]};
+        int fd{STDOUT_FILENO};
+        if (!recording.isOpen()) {
+            retCode = 1;
+        } else if (commandline("out")) {
+            fd = ::open(commandline("out").str().c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (0 > fd) {
+                std::cerr << "[oxts-convert] Failed to open " << commandline("out").str() << ": " << ::strerror(errno) << std::endl;
+                retCode = 1;
+            }
+        }
+
+        if (0 == retCode) {
+            uint32_t threads{std::thread::hardware_concurrency()};
+            commandline("threads", threads) >> threads;
+
+            OxTSConverter converter{("json" == FORMAT) ? OxTSConverter::Format::JSON : OxTSConverter::Format::CSV, threads};
+            const std::chrono::steady_clock::time_point START{std::chrono::steady_clock::now()};
+            const OxTSConverter::Summary SUMMARY{converter.convert(recording.begin(), recording.end(),
+                [fd](const char *data, std::size_t length) { return writeAll(fd, data, length); })};
+            const std::chrono::duration<double> ELAPSED{std::chrono::steady_clock::now() - START};
+
+            if (!SUMMARY.completed) {
+                std::cerr << "[oxts-convert] Failed to write: " << ::strerror(errno) << std::endl;
+                retCode = 1;
+            }
+            if ( (STDOUT_FILENO != fd) && (0 != ::close(fd)) ) {
+                std::cerr << "[oxts-convert] Failed to close " << commandline("out").str() << ": " << ::strerror(errno) << std::endl;
+                retCode = 1;
+            }
+            std::cerr << "[oxts-convert] " << SUMMARY.packets << " packets in " << std::fixed << std::setprecision(3) << ELAPSED.count() << " s ("
+                      << std::setprecision(1) << ((0.0 < ELAPSED.count()) ? static_cast<double>(SUMMARY.packets) / ELAPSED.count() : 0.0) << " packets/s), "
+                      << SUMMARY.skipped << " of " << recording.size() << " bytes skipped" << std::endl;
+        }
+    }
+    return retCode;
+}
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "oxts-converter.hpp"
+#include "oxts-decoder.hpp"
+#include "oxts-ncom.hpp"
+#include "oxts-recording.hpp"
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+// Decimals match the resolution of the NCOM channels.
+const char CSV_HEADER[]{"time,navigation,latitude,longitude,altitude,heading,pitch,roll,"
+                        "velocityNorth,velocityEast,velocityDown,"
+                        "accelerationX,accelerationY,accelerationZ,angularVelocityX,angularVelocityY,angularVelocityZ\n"};
+const char CSV_ROW[]{"%u,%u,%.9f,%.9f,%.3f,%.6f,%.6f,%.6f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.5f,%.5f,%.5f\n"};
+const char JSON_ROW[]{"{\"time\":%u,\"navigation\":%u,\"latitude\":%.9f,\"longitude\":%.9f,\"altitude\":%.3f,"
+                      "\"heading\":%.6f,\"pitch\":%.6f,\"roll\":%.6f,"
+                      "\"velocityNorth\":%.4f,\"velocityEast\":%.4f,\"velocityDown\":%.4f,"
+                      "\"accelerationX\":%.4f,\"accelerationY\":%.4f,\"accelerationZ\":%.4f,"
+                      "\"angularVelocityX\":%.5f,\"angularVelocityY\":%.5f,\"angularVelocityZ\":%.5f}\n"};
+
+// Formatted packets of one chunk.
+struct Chunk {
+    std::string text{};
+    // First packet and the byte following the last packet; nullptr if there was none.
+    const uint8_t *first{nullptr};
+    const uint8_t *last{nullptr};
+    uint64_t packets{0};
+    bool isDone{false};
+};
+
+// Columns of one run of contiguous packets.
+class Block {
+   public:
+    static constexpr std::size_t CAPACITY{1024};
+
+    Block() noexcept {
+        m_columns.latitude         = m_latitude.data();
+        m_columns.longitude        = m_longitude.data();
+        m_columns.altitude         = m_floats[0].data();
+        m_columns.northHeading     = m_floats[1].data();
+        m_columns.pitch            = m_floats[2].data();
+        m_columns.roll             = m_floats[3].data();
+        m_columns.velocityNorth    = m_floats[4].data();
+        m_columns.velocityEast     = m_floats[5].data();
+        m_columns.velocityDown     = m_floats[6].data();
+        m_columns.accelerationX    = m_floats[7].data();
+        m_columns.accelerationY    = m_floats[8].data();
+        m_columns.accelerationZ    = m_floats[9].data();
+        m_columns.angularVelocityX = m_floats[10].data();
+        m_columns.angularVelocityY = m_floats[11].data();
+        m_columns.angularVelocityZ = m_floats[12].data();
+    }
+
+    // Decodes count contiguous packets and appends one row per packet.
+    void format(OxTSDecoder &decoder, const char *row, const uint8_t *packets, std::size_t count, std::string &text) noexcept {
+        decoder.decodeBatch(packets, count, m_columns);
+        std::array<char, 512> buffer;
+        for (std::size_t i{0}; i < count; i++) {
+            const uint8_t *packet{packets + i * ncom::PACKET_LENGTH};
+            const int LENGTH{std::snprintf(buffer.data(), buffer.size(), row,
+                static_cast<uint32_t>(ncom::raw<ncom::Time>(packet)), static_cast<uint32_t>(ncom::raw<ncom::NavigationStatus>(packet)),
+                m_latitude[i], m_longitude[i], static_cast<double>(m_floats[0][i]),
+                static_cast<double>(m_floats[1][i]), static_cast<double>(m_floats[2][i]), static_cast<double>(m_floats[3][i]),
+                static_cast<double>(m_floats[4][i]), static_cast<double>(m_floats[5][i]), static_cast<double>(m_floats[6][i]),
+                static_cast<double>(m_floats[7][i]), static_cast<double>(m_floats[8][i]), static_cast<double>(m_floats[9][i]),
+                static_cast<double>(m_floats[10][i]), static_cast<double>(m_floats[11][i]), static_cast<double>(m_floats[12][i]))};
+            if (0 < LENGTH) {
+                text.append(buffer.data(), std::min(static_cast<std::size_t>(LENGTH), buffer.size() - 1));
+            }
+        }
+    }
+
+   private:
+    OxTSDecoder::Columns m_columns{};
+    std::array<double, CAPACITY> m_latitude{};
+    std::array<double, CAPACITY> m_longitude{};
+    std::array<std::array<float, CAPACITY>, 13> m_floats{};
+};
+
+// Converts the packets starting in [from, until); packets may extend up to end.
+void convertRange(const char *row, const uint8_t *from, const uint8_t *until, const uint8_t *end, Chunk &chunk) {
+    OxTSDecoder decoder{OxTSDecoder::Gating::NONE};
+    std::unique_ptr<Block> block{new Block()};
+    chunk.text.clear();
+    chunk.first   = nullptr;
+    chunk.last    = nullptr;
+    chunk.packets = 0;
+    chunk.text.reserve(static_cast<std::size_t>(until - from) * 3);
+
+    const uint8_t *packet{OxTSRecording::findPacket(from, end)};
+    while (packet < until) {
+        // Extend the run as long as the next packet follows immediately.
+        std::size_t count{1};
+        while ( (count < Block::CAPACITY) && (packet + (count + 1) * ncom::PACKET_LENGTH <= end)
+                && (packet + count * ncom::PACKET_LENGTH < until) ) {
+            const uint8_t *next{packet + count * ncom::PACKET_LENGTH};
+            if (next != OxTSRecording::findPacket(next, next + ncom::PACKET_LENGTH)) {
+                break;
+            }
+            count++;
+        }
+        block->format(decoder, row, packet, count, chunk.text);
+
+        chunk.first = (nullptr == chunk.first) ? packet : chunk.first;
+        chunk.packets += count;
+        packet += count * ncom::PACKET_LENGTH;
+        chunk.last = packet;
+        packet = OxTSRecording::findPacket(packet, end);
+    }
+}
+} // namespace
+
+constexpr std::size_t OxTSConverter::CHUNK_SIZE;
+
+OxTSConverter::OxTSConverter(Format format, uint32_t threads, std::size_t chunkSize) noexcept
+    : m_format(format)
+    , m_threads(std::max<uint32_t>(1, threads))
+    , m_chunkSize(std::max(chunkSize, ncom::PACKET_LENGTH)) {}
+
+OxTSConverter::Summary OxTSConverter::convert(const uint8_t *begin, const uint8_t *end, const Writer &writer) {
+    Summary summary;
+    const char *ROW{(Format::CSV == m_format) ? CSV_ROW : JSON_ROW};
+    if ( (Format::CSV == m_format) && !writer(CSV_HEADER, sizeof(CSV_HEADER) - 1) ) {
+        return summary;
+    }
+
+    const std::size_t SIZE{(nullptr == begin) ? 0 : static_cast<std::size_t>(end - begin)};
+    const std::size_t COUNT{(SIZE + m_chunkSize - 1) / m_chunkSize};
+    auto chunkBegin = [begin, SIZE, this](std::size_t i) { return begin + std::min(i * m_chunkSize, SIZE); };
+
+    // Chunks are claimed in order; at most WINDOW formatted chunks wait for the writer.
+    const std::size_t WINDOW{2 * static_cast<std::size_t>(m_threads)};
+    std::vector<Chunk> chunks(COUNT);
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::size_t claimed{0};
+    std::size_t written{0};
+    bool aborted{false};
+
+    auto work = [&]() {
+        while (true) {
+            std::size_t i{0};
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]() { return aborted || (COUNT <= claimed) || (claimed < written + WINDOW); });
+                if (aborted || (COUNT <= claimed)) {
+                    return;
+                }
+                i = claimed++;
+            }
+            convertRange(ROW, chunkBegin(i), chunkBegin(i + 1), end, chunks[i]);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                chunks[i].isDone = true;
+            }
+            changed.notify_all();
+        }
+    };
+    std::vector<std::thread> workers;
+    for (uint32_t t{0}; t < m_threads; t++) {
+        workers.emplace_back(work);
+    }
+
+    const uint8_t *previousLast{begin};
+    bool completed{true};
+    for (std::size_t i{0}; i < COUNT; i++) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() { return chunks[i].isDone; });
+        }
+        Chunk &chunk = chunks[i];
+        if ( (nullptr != chunk.first) && (chunk.first < previousLast) ) {
+            // The chunk synchronized within the previous chunk's last packet.
+            convertRange(ROW, previousLast, chunkBegin(i + 1), end, chunk);
+            summary.resynchronized++;
+        }
+        if (nullptr != chunk.last) {
+            previousLast = chunk.last;
+        }
+        summary.packets += chunk.packets;
+        if (!chunk.text.empty() && !writer(chunk.text.data(), chunk.text.size())) {
+            completed = false;
+        }
+        std::string().swap(chunk.text);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            written++;
+            aborted = !completed;
+        }
+        changed.notify_all();
+        if (!completed) {
+            break;
+        }
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    summary.skipped   = SIZE - static_cast<std::size_t>(summary.packets) * ncom::PACKET_LENGTH;
+    summary.completed = completed;
+    return summary;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_CONVERTER
+#define OXTS_CONVERTER
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * Bulk converter from raw NCOM recordings to CSV or JSON Lines: The input is
+ * split into chunks that are decoded column-wise with decodeBatch() and
+ * formatted by a pool of threads; the formatted chunks are handed to the
+ * writer in file order.
+ *
+ * Each chunk resynchronizes on the first sync byte with a valid checksum;
+ * if that lies within the last packet of the previous chunk, the chunk is
+ * converted again from the end of that packet, so that the output is
+ * identical to converting the whole file sequentially.
+ */
+class OxTSConverter {
+   private:
+    OxTSConverter(const OxTSConverter &) = delete;
+    OxTSConverter(OxTSConverter &&)      = delete;
+    OxTSConverter &operator=(const OxTSConverter &) = delete;
+    OxTSConverter &operator=(OxTSConverter &&) = delete;
+
+   public:
+    enum class Format : uint8_t {
+        CSV,  // One header line followed by one line per packet.
+        JSON, // One JSON object per packet and line.
+    };
+
+    static constexpr std::size_t CHUNK_SIZE{4 * 1024 * 1024};
+
+    /**
+     * Delegate to write formatted text; returning false aborts the conversion.
+     */
+    using Writer = std::function<bool(const char *, std::size_t)>;
+
+    struct Summary {
+        uint64_t packets{0};
+        // Bytes outside of packets.
+        std::size_t skipped{0};
+        // Chunks converted again as their first packet overlapped the previous chunk.
+        uint64_t resynchronized{0};
+        bool completed{false};
+    };
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param format Output format.
+     * @param threads Number of converting threads.
+     * @param chunkSize Number of input bytes per chunk.
+     */
+    OxTSConverter(Format format, uint32_t threads, std::size_t chunkSize = CHUNK_SIZE) noexcept;
+    ~OxTSConverter() = default;
+
+    /**
+     * This method converts all packets between begin and end.
+     *
+     * @param begin First byte of the recording.
+     * @param end First byte after the recording.
+     * @param writer Delegate called with the formatted chunks in file order.
+     * @return Summary of the conversion.
+     */
+    Summary convert(const uint8_t *begin, const uint8_t *end, const Writer &writer);
+
+   private:
+    const Format m_format;
+    const uint32_t m_threads;
+    const std::size_t m_chunkSize;
+};
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_COUNTERS
+#define OXTS_COUNTERS
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Statistics counters are written by a single thread and read concurrently
+ * by the reporting threads. As there is only one writer, a relaxed load and
+ * store suffice and avoid the cost of the locked read-modify-write of
+ * fetch_add on every packet.
+ */
+namespace counters {
+
+inline void add(std::atomic<uint64_t> &counter, uint64_t value) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+inline void increment(std::atomic<uint64_t> &counter) noexcept {
+    add(counter, 1);
+}
+
+} // namespace counters
+
+#endif
@@ -16,67 +16,407 @@
  */
 
 #include "cluon-complete.hpp"
+#include "oxts-counters.hpp"
 #include "oxts-decoder.hpp"
+#include "oxts-kernels.hpp"
+#include "oxts-ncom.hpp"
 
 #include <cmath>
 #include <cstring>
+#include <algorithm>
 #include <array>
-#include <sstream>
-#include <string>
+
+namespace {
+using counters::add;
+using counters::increment;
+
+// Adds bytes [begin, end) of the packet to the running NCOM checksum.
+inline uint8_t accumulate(uint8_t sum, const uint8_t *data, std::size_t begin, std::size_t end) noexcept {
+    // Sum without truncating in every step so that the loop can be vectorized.
+    uint32_t total{sum};
+    for (std::size_t i{begin}; i < end; i++) {
+        total += data[i];
+    }
+    return static_cast<uint8_t>(total);
+}
+
+void decodeBatchA(const uint8_t *data, OxTSDecoder::Readings &readings) noexcept {
+    readings.batches |= OxTSDecoder::BATCH_A;
+
+    // Decode accelerations [m/s^2].
+    readings.acceleration.accelerationX(ncom::value<ncom::AccelerationX>(data))
+                         .accelerationY(ncom::value<ncom::AccelerationY>(data))
+                         .accelerationZ(ncom::value<ncom::AccelerationZ>(data));
+
+    // Decode angular rates [rad/s].
+    readings.angularVelocity.angularVelocityX(ncom::value<ncom::AngularRateX>(data))
+                            .angularVelocityY(ncom::value<ncom::AngularRateY>(data))
+                            .angularVelocityZ(ncom::value<ncom::AngularRateZ>(data));
+}
+
+void decodeBatchB(const uint8_t *data, OxTSDecoder::Readings &readings) noexcept {
+    readings.batches |= OxTSDecoder::BATCH_B;
+
+    // Decode latitude/longitude.
+    readings.position.latitude(ncom::value<ncom::Latitude>(data) / M_PI * 180.0)
+                     .longitude(ncom::value<ncom::Longitude>(data) / M_PI * 180.0);
+
+    // Decode altitude [m].
+    readings.altitude.altitude(ncom::value<ncom::Altitude>(data));
+
+    // Decode velocities north/east/down [m/s].
+    readings.equilibrioception.vx(ncom::value<ncom::VelocityNorth>(data))
+                              .vy(ncom::value<ncom::VelocityEast>(data))
+                              .vz(ncom::value<ncom::VelocityDown>(data))
+                              .rollRate(readings.angularVelocity.angularVelocityX())
+                              .pitchRate(readings.angularVelocity.angularVelocityY())
+                              .yawRate(readings.angularVelocity.angularVelocityZ());
+
+    // Decode heading, pitch, and roll [rad].
+    readings.heading.northHeading(ncom::normalizeAngle(ncom::value<ncom::Heading>(data)));
+    readings.pitch = ncom::normalizeAngle(ncom::value<ncom::Pitch>(data));
+    readings.roll = ncom::normalizeAngle(ncom::value<ncom::Roll>(data));
+}
+// @return true if the accuracies are recent enough to be valid.
+template <typename SCALE>
+bool decodeAccuracy(const uint8_t *data, std::array<float, 3> &accuracy) noexcept {
+    accuracy[0] = ncom::value<ncom::status::Accuracy<0, SCALE> >(data);
+    accuracy[1] = ncom::value<ncom::status::Accuracy<1, SCALE> >(data);
+    accuracy[2] = ncom::value<ncom::status::Accuracy<2, SCALE> >(data);
+    return ncom::raw<ncom::status::AccuracyAge>(data) < ncom::status::MAX_ACCURACY_AGE;
+}
+
+// @return Batches that hold valid data under the given navigation status.
+uint8_t admittedBatches(uint8_t navigationStatus) noexcept {
+    switch (navigationStatus) {
+        case ncom::navigation::LOCKED:
+            return OxTSDecoder::BATCH_A | OxTSDecoder::BATCH_B | OxTSDecoder::BATCH_S;
+        case ncom::navigation::RAW_IMU:
+            return OxTSDecoder::BATCH_A | OxTSDecoder::BATCH_S;
+        case ncom::navigation::INITIALISING:
+        case ncom::navigation::LOCKING:
+        case ncom::navigation::STATUS_ONLY:
+            return OxTSDecoder::BATCH_S;
+        default:
+            return 0;
+    }
+}
+
+bool operator==(const OxTSDecoder::Status &lhs, const OxTSDecoder::Status &rhs) noexcept {
+    return (lhs.valid == rhs.valid) && (lhs.satellites == rhs.satellites) && (lhs.positionMode == rhs.positionMode)
+           && (lhs.velocityMode == rhs.velocityMode) && (lhs.orientationMode == rhs.orientationMode)
+           && (lhs.navigationStatus == rhs.navigationStatus)
+           && (lhs.positionAccuracy == rhs.positionAccuracy) && (lhs.velocityAccuracy == rhs.velocityAccuracy)
+           && (lhs.orientationAccuracy == rhs.orientationAccuracy);
+}
+} // namespace
+
+constexpr std::chrono::milliseconds OxTSDecoder::NOMINAL_PERIOD;
+constexpr uint32_t OxTSDecoder::SEQUENCE_HISTORY;
+
+OxTSDecoder::OxTSDecoder(Gating gating, std::chrono::milliseconds period) noexcept
+    : m_gating(gating)
+    , m_period(static_cast<int32_t>(std::max<std::chrono::milliseconds::rep>(1, period.count()))) {}
 
 std::pair<bool, std::pair<opendlv::proxy::GeodeticWgs84Reading, opendlv::proxy::GeodeticHeadingReading> >
     OxTSDecoder::decode(const std::string &data) noexcept {
-    bool retVal{false};
-    opendlv::proxy::GeodeticWgs84Reading gps;
-    opendlv::proxy::GeodeticHeadingReading heading;
-
-    constexpr std::size_t OXTS_PACKET_LENGTH{72};
-    constexpr uint8_t OXTS_FIRST_BYTE{0xE7};
-    if ( (OXTS_PACKET_LENGTH == data.size()) && (OXTS_FIRST_BYTE == static_cast<uint8_t>(data.at(0))) ) {
-        std::stringstream buffer{data};
-
-        // Decode latitude/longitude.
-        {
-            double latitude{0.0};
-            double longitude{0.0};
-
-            // Move to where latitude/longitude are encoded.
-            constexpr uint32_t START_OF_LAT_LON{23};
-            buffer.seekg(START_OF_LAT_LON);
-            buffer.read(reinterpret_cast<char*>(&latitude), sizeof(double));
-            buffer.read(reinterpret_cast<char*>(&longitude), sizeof(double));
-
-            gps.latitude(latitude / M_PI * 180.0).longitude(longitude / M_PI * 180.0);
+    return decode(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+std::pair<bool, std::pair<opendlv::proxy::GeodeticWgs84Reading, opendlv::proxy::GeodeticHeadingReading> >
+    OxTSDecoder::decode(const uint8_t *data, std::size_t length) noexcept {
+    Readings readings;
+    const bool retVal{decode(data, length, readings) && (0 != (readings.batches & BATCH_B))};
+    return std::make_pair(retVal, std::make_pair(readings.position, readings.heading));
+}
+
+bool OxTSDecoder::decode(const uint8_t *data, std::size_t length, Readings &readings) noexcept {
+    increment(m_statistics.packets);
+    readings.batches       = 0;
+    readings.statusChanges = 0;
+    readings.sequence      = Sequence::START;
+
+    if ( (nullptr == data) || (ncom::PACKET_LENGTH != length) ) {
+        increment(m_statistics.invalidLength);
+        increment(m_statistics.rejected);
+        return false;
+    }
+    if (ncom::SYNC != ncom::raw<ncom::Sync>(data)) {
+        increment(m_statistics.invalidSync);
+        increment(m_statistics.rejected);
+        return false;
+    }
+
+    // Each checksum is the sum of all bytes following the sync byte up to
+    // the checksum itself. The running sum is carried on from batch to
+    // batch; a later checksum also vouches for the earlier batches.
+    uint8_t valid{0};
+    uint8_t sum{accumulate(0, data, ncom::Sync::OFFSET + ncom::Sync::WIDTH, ncom::Checksum1::OFFSET)};
+    if (sum == ncom::raw<ncom::Checksum1>(data)) {
+        valid = BATCH_A;
+    } else {
+        increment(m_statistics.invalidChecksum1);
+    }
+
+    sum = accumulate(sum, data, ncom::Checksum1::OFFSET, ncom::Checksum2::OFFSET);
+    if (sum == ncom::raw<ncom::Checksum2>(data)) {
+        valid = BATCH_A | BATCH_B;
+    } else {
+        increment(m_statistics.invalidChecksum2);
+    }
+
+    sum = accumulate(sum, data, ncom::Checksum2::OFFSET, ncom::Checksum3::OFFSET);
+    if (sum == ncom::raw<ncom::Checksum3>(data)) {
+        valid = BATCH_A | BATCH_B | BATCH_S;
+    } else {
+        increment(m_statistics.invalidChecksum3);
+    }
+
+    if (0 == valid) {
+        increment(m_statistics.rejected);
+        return false;
+    }
+
+    // Every checksum covers the time, too; track the sequence regardless of the navigation status.
+    readings.sequence = trackSequence(ncom::raw<ncom::Time>(data));
+
+    // Every checksum covers the navigation status; decide before converting anything.
+    const uint8_t NAVIGATION{ncom::raw<ncom::NavigationStatus>(data)};
+    if ( (0 == (m_status.valid & NAVIGATION_STATUS)) || (NAVIGATION != m_status.navigationStatus) ) {
+        m_status.navigationStatus = NAVIGATION;
+        m_status.valid |= NAVIGATION_STATUS;
+        readings.statusChanges |= NAVIGATION_STATUS;
+    }
+    const uint8_t BATCHES{(Gating::LOCKED == m_gating) ? static_cast<uint8_t>(valid & admittedBatches(NAVIGATION)) : valid};
+    if (BATCHES != valid) {
+        increment(m_statistics.gated);
+    }
+
+    if (0 != (BATCHES & BATCH_A)) {
+        decodeBatchA(data, readings);
+    }
+    if (0 != (BATCHES & BATCH_B)) {
+        decodeBatchB(data, readings);
+    }
+    if (0 != (BATCHES & BATCH_S)) {
+        readings.batches |= BATCH_S;
+        readings.statusChanges |= decodeStatus(data);
+    }
+
+    if (0 != readings.batches) {
+        decodeGpsTime(data, readings);
+    }
+    return (0 != readings.batches);
+}
+
+OxTSDecoder::Sequence OxTSDecoder::trackSequence(uint16_t time) noexcept {
+    if (ncom::MILLISECONDS_PER_MINUTE <= time) {
+        return Sequence::START;
+    }
+
+    // Periods since the newest packet, taking the shorter way around the minute.
+    constexpr int32_t MINUTE{static_cast<int32_t>(ncom::MILLISECONDS_PER_MINUTE)};
+    int32_t delta{(static_cast<int32_t>(time) - static_cast<int32_t>(m_newestTime) + MINUTE) % MINUTE};
+    delta = (delta >= MINUTE / 2) ? delta - MINUTE : delta;
+    const int32_t PERIODS{(delta + ((0 > delta) ? -m_period : m_period) / 2) / m_period};
+
+    Sequence retVal{Sequence::START};
+    if (!m_hasNewestTime || (-static_cast<int32_t>(SEQUENCE_HISTORY) >= PERIODS)) {
+        m_hasNewestTime = true;
+        m_newestTime    = time;
+        m_receivedTimes = 1;
+    } else if (0 < PERIODS) {
+        retVal = (1 == PERIODS) ? Sequence::IN_ORDER : Sequence::AFTER_GAP;
+        add(m_statistics.missing, static_cast<uint64_t>(PERIODS - 1));
+        m_newestTime    = time;
+        m_receivedTimes = (static_cast<int32_t>(SEQUENCE_HISTORY) <= PERIODS) ? 1 : ((m_receivedTimes << PERIODS) | 1);
+    } else {
+        const uint64_t BIT{uint64_t{1} << -PERIODS};
+        retVal = (0 != (m_receivedTimes & BIT)) ? Sequence::DUPLICATE : Sequence::REORDERED;
+        increment((Sequence::DUPLICATE == retVal) ? m_statistics.duplicates : m_statistics.reordered);
+        m_receivedTimes |= BIT;
+    }
+    return retVal;
+}
+
+void OxTSDecoder::decodeGpsTime(const uint8_t *data, Readings &readings) noexcept {
+    readings.time       = ncom::raw<ncom::Time>(data);
+    readings.hasGpsTime = false;
+    if (ncom::MILLISECONDS_PER_MINUTE <= readings.time) {
+        return;
+    }
+
+    uint32_t minutes{m_gpsMinutes};
+    if ( (Sequence::DUPLICATE == readings.sequence) || (Sequence::REORDERED == readings.sequence) ) {
+        // Late packets neither carry the minute on nor set it; they may belong to the previous minute.
+        minutes -= (readings.time > m_previousTime) ? 1 : 0;
+    } else {
+        if ( (0 != (readings.batches & BATCH_S))
+             && (ncom::status::GPS_TIME_CHANNEL == ncom::raw<ncom::StatusChannel>(data)) ) {
+            m_gpsMinutes    = ncom::raw<ncom::status::GpsMinutes>(data);
+            m_hasGpsMinutes = true;
+        } else if (m_hasGpsMinutes && (readings.time < m_previousTime)) {
+            // The milliseconds wrapped around since the previous packet.
+            m_gpsMinutes++;
         }
+        m_previousTime = readings.time;
+        minutes        = m_gpsMinutes;
+    }
 
-        // Decode heading.
-        {
-            float northHeading{0.0f};
-
-            // Move to where heading is encoded.
-            constexpr uint32_t START_OF_HEADING{52};
-            buffer.seekg(START_OF_HEADING);
-
-            // Extract only three bytes from OxTS.
-            std::array<char, 4> tmp{0, 0, 0, 0};
-            buffer.read(tmp.data(), 3);
-            uint32_t value{0};
-            std::memcpy(&value, tmp.data(), 4);
-            value = le32toh(value);
-            northHeading = value * 1e-6f;
-
-            // Normalize between -M_PI .. M_PI.
-            while (northHeading < -M_PI) {
-                northHeading += 2.0f * static_cast<float>(M_PI);
-            }
-            while (northHeading > M_PI) {
-                northHeading -= 2.0f * static_cast<float>(M_PI);
+    if (m_hasGpsMinutes) {
+        readings.hasGpsTime = true;
+        readings.gpsTime    = std::chrono::minutes{minutes} + std::chrono::milliseconds{readings.time};
+    }
+}
+
+uint32_t OxTSDecoder::decodeStatus(const uint8_t *data) noexcept {
+    const uint8_t CHANNEL{ncom::raw<ncom::StatusChannel>(data)};
+    uint64_t bytes{0};
+    std::memcpy(&bytes, data + ncom::status::DATA_OFFSET, ncom::status::DATA_LENGTH);
+    if (m_receivedChannels[CHANNEL] && (bytes == m_statusChannels[CHANNEL])) {
+        // Most channels repeat unchanged; skip decoding them again.
+        return 0;
+    }
+    m_receivedChannels.set(CHANNEL);
+    m_statusChannels[CHANNEL] = bytes;
+
+    Status status{m_status};
+    uint32_t field{0};
+    bool isValid{true};
+    switch (CHANNEL) {
+        case ncom::status::GPS_TIME_CHANNEL:
+            field                  = GNSS_STATE;
+            status.satellites      = ncom::raw<ncom::status::Satellites>(data);
+            status.positionMode    = ncom::raw<ncom::status::PositionMode>(data);
+            status.velocityMode    = ncom::raw<ncom::status::VelocityMode>(data);
+            status.orientationMode = ncom::raw<ncom::status::OrientationMode>(data);
+            break;
+        case ncom::status::POSITION_ACCURACY_CHANNEL:
+            field   = POSITION_ACCURACY;
+            isValid = decodeAccuracy<ncom::status::PositionAccuracyScale>(data, status.positionAccuracy);
+            break;
+        case ncom::status::VELOCITY_ACCURACY_CHANNEL:
+            field   = VELOCITY_ACCURACY;
+            isValid = decodeAccuracy<ncom::status::VelocityAccuracyScale>(data, status.velocityAccuracy);
+            break;
+        case ncom::status::ORIENTATION_ACCURACY_CHANNEL:
+            field   = ORIENTATION_ACCURACY;
+            isValid = decodeAccuracy<ncom::status::OrientationAccuracyScale>(data, status.orientationAccuracy);
+            break;
+        default:
+            return 0;
+    }
+    status.valid = isValid ? (status.valid | field) : (status.valid & ~field);
+
+    // The raw bytes also change with the minute or the age of the accuracies.
+    if (status == m_status) {
+        return 0;
+    }
+    m_status = status;
+    return field;
+}
+
+std::size_t OxTSDecoder::decodeBatch(const uint8_t *packets, std::size_t count, const Columns &columns) noexcept {
+    if (nullptr == packets) {
+        return 0;
+    }
+
+    const std::array<std::pair<float*, ncom::Channel24>, 12> CHANNELS{{
+        {columns.northHeading, ncom::channel24<ncom::Heading>(true)},
+        {columns.accelerationX, ncom::channel24<ncom::AccelerationX>()},
+        {columns.accelerationY, ncom::channel24<ncom::AccelerationY>()},
+        {columns.accelerationZ, ncom::channel24<ncom::AccelerationZ>()},
+        {columns.angularVelocityX, ncom::channel24<ncom::AngularRateX>()},
+        {columns.angularVelocityY, ncom::channel24<ncom::AngularRateY>()},
+        {columns.angularVelocityZ, ncom::channel24<ncom::AngularRateZ>()},
+        {columns.velocityNorth, ncom::channel24<ncom::VelocityNorth>()},
+        {columns.velocityEast, ncom::channel24<ncom::VelocityEast>()},
+        {columns.velocityDown, ncom::channel24<ncom::VelocityDown>()},
+        {columns.pitch, ncom::channel24<ncom::Pitch>(true)},
+        {columns.roll, ncom::channel24<ncom::Roll>(true)},
+    }};
+    const ncom::Kernel KERNEL{ncom::bestKernel()};
+
+    // Count locally and publish the counters once per batch.
+    uint64_t invalidSync{0};
+    uint64_t invalidChecksum1{0};
+    uint64_t invalidChecksum2{0};
+    uint64_t invalidChecksum3{0};
+    uint64_t rejected{0};
+    uint64_t gated{0};
+    std::size_t validPackets{0};
+
+    // Blocks of packets stay in L1 cache while the column kernels pass over them.
+    constexpr std::size_t BLOCK{256};
+    for (std::size_t begin{0}; begin < count; begin += BLOCK) {
+        const std::size_t LENGTH{std::min(BLOCK, count - begin)};
+        const uint8_t *block{packets + begin * ncom::PACKET_LENGTH};
+
+        for (const auto &channel : CHANNELS) {
+            if (nullptr != channel.first) {
+                ncom::extract24(KERNEL, block, LENGTH, channel.second, channel.first + begin);
             }
+        }
+
+        for (std::size_t i{begin}; i < begin + LENGTH; i++) {
+            const uint8_t *data{packets + i * ncom::PACKET_LENGTH};
+
+            uint8_t sum{accumulate(0, data, ncom::Sync::OFFSET + ncom::Sync::WIDTH, ncom::Checksum1::OFFSET)};
+            const bool CHECKSUM1{sum == ncom::raw<ncom::Checksum1>(data)};
+            sum = accumulate(sum, data, ncom::Checksum1::OFFSET, ncom::Checksum2::OFFSET);
+            const bool CHECKSUM2{sum == ncom::raw<ncom::Checksum2>(data)};
+            sum = accumulate(sum, data, ncom::Checksum2::OFFSET, ncom::Checksum3::OFFSET);
+            const bool CHECKSUM3{sum == ncom::raw<ncom::Checksum3>(data)};
 
-            heading.northHeading(northHeading);
+            const bool SYNC{ncom::SYNC == ncom::raw<ncom::Sync>(data)};
+            const bool CHECKED{SYNC && (CHECKSUM2 || CHECKSUM3)};
+            const bool ADMITTED{(Gating::NONE == m_gating) || (0 != (admittedBatches(ncom::raw<ncom::NavigationStatus>(data)) & BATCH_B))};
+            const bool VALID{CHECKED && ADMITTED};
+            gated += ((CHECKED && !ADMITTED) ? 1 : 0);
+            invalidSync += (SYNC ? 0 : 1);
+            invalidChecksum1 += ((!SYNC || CHECKSUM1) ? 0 : 1);
+            invalidChecksum2 += ((!SYNC || CHECKSUM2) ? 0 : 1);
+            invalidChecksum3 += ((!SYNC || CHECKSUM3) ? 0 : 1);
+            rejected += ((SYNC && (CHECKSUM1 || CHECKSUM2 || CHECKSUM3)) ? 0 : 1);
+            validPackets += (VALID ? 1 : 0);
+
+            if (nullptr != columns.latitude) {
+                columns.latitude[i] = VALID ? ncom::value<ncom::Latitude>(data) / M_PI * 180.0 : 0.0;
+            }
+            if (nullptr != columns.longitude) {
+                columns.longitude[i] = VALID ? ncom::value<ncom::Longitude>(data) / M_PI * 180.0 : 0.0;
+            }
+            if (nullptr != columns.altitude) {
+                columns.altitude[i] = VALID ? ncom::value<ncom::Altitude>(data) : 0.0f;
+            }
+            if (nullptr != columns.valid) {
+                columns.valid[i] = (VALID ? 1 : 0);
+            }
+            if (!VALID) {
+                for (const auto &channel : CHANNELS) {
+                    if (nullptr != channel.first) {
+                        channel.first[i] = 0.0f;
+                    }
+                }
+            }
         }
-        retVal = true;
     }
-    return std::make_pair(retVal, std::make_pair(gps, heading));
+
+    add(m_statistics.packets, count);
+    add(m_statistics.invalidSync, invalidSync);
+    add(m_statistics.invalidChecksum1, invalidChecksum1);
+    add(m_statistics.invalidChecksum2, invalidChecksum2);
+    add(m_statistics.invalidChecksum3, invalidChecksum3);
+    add(m_statistics.rejected, rejected);
+    add(m_statistics.gated, gated);
+
+    return validPackets;
 }
 
+const OxTSDecoder::Status &OxTSDecoder::status() const noexcept {
+    return m_status;
+}
+
+const OxTSDecoder::Statistics &OxTSDecoder::statistics() const noexcept {
+    return m_statistics;
+}
@@ -20,6 +20,12 @@
 
 #include "opendlv-standard-message-set.hpp"
 
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <chrono>
 #include <string>
 #include <utility>
 
@@ -31,13 +37,235 @@ class OxTSDecoder {
     OxTSDecoder &operator=(OxTSDecoder &&) = delete;
 
    public:
+    /**
+     * Parts of an NCOM packet that are covered by a valid checksum.
+     */
+    enum Batch : uint8_t {
+        BATCH_A = 0x1, // Time, accelerations, angular rates, and navigation status.
+        BATCH_B = 0x2, // Position, altitude, velocities, and attitude.
+        BATCH_S = 0x4, // Status channel.
+    };
+
+    /**
+     * Handling of packets by their navigation status.
+     */
+    enum class Gating : uint8_t {
+        NONE,   // Decode every packet; the navigation status is only reported.
+        LOCKED, // Decode navigation only while locked; see decode().
+    };
+
+    /**
+     * Position of a packet in the sequence of NCOM times (ms within the GPS
+     * minute) at the nominal output rate, relative to the newest packet.
+     */
+    enum class Sequence : uint8_t {
+        START,     // First packet, invalid time, or a jump back in time; continuity starts anew.
+        IN_ORDER,  // One period after the newest packet.
+        AFTER_GAP, // More than one period after the newest packet; the packets in between are missing.
+        DUPLICATE, // Same time as a packet that was already received.
+        REORDERED, // Older than the newest packet and received for the first time.
+    };
+
+    /**
+     * Groups of slowly changing fields assembled from the status channels.
+     */
+    enum StatusField : uint32_t {
+        GNSS_STATE           = 0x1, // Number of satellites and position/velocity/orientation modes.
+        POSITION_ACCURACY    = 0x2,
+        VELOCITY_ACCURACY    = 0x4,
+        ORIENTATION_ACCURACY = 0x8,
+        NAVIGATION_STATUS    = 0x10, // Byte 21 of every packet.
+    };
+
+    /**
+     * State of the unit as reported by the rotating status channels; each
+     * packet carries one channel, so the state is assembled incrementally.
+     */
+    struct Status {
+        // StatusFields that were received and are currently valid.
+        uint32_t valid{0};
+        uint8_t satellites{0};
+        uint8_t positionMode{0};
+        uint8_t velocityMode{0};
+        uint8_t orientationMode{0};
+        // Navigation status of the latest packet with a valid checksum.
+        uint8_t navigationStatus{0};
+        // Standard deviations north/east/down [m], [m/s], and of heading/pitch/roll [rad].
+        std::array<float, 3> positionAccuracy{{0.0f, 0.0f, 0.0f}};
+        std::array<float, 3> velocityAccuracy{{0.0f, 0.0f, 0.0f}};
+        std::array<float, 3> orientationAccuracy{{0.0f, 0.0f, 0.0f}};
+    };
+
+    /**
+     * All channels decoded from a single NCOM packet.
+     */
+    struct Readings {
+        // Batches that passed their checksums; only their channels are updated.
+        uint8_t batches{0};
+        opendlv::proxy::AccelerationReading acceleration{};
+        opendlv::proxy::AngularVelocityReading angularVelocity{};
+        opendlv::proxy::GeodeticWgs84Reading position{};
+        opendlv::proxy::AltitudeReading altitude{};
+        opendlv::proxy::GeodeticHeadingReading heading{};
+        // Velocities north/east/down together with the angular rates.
+        opendlv::logic::sensation::Equilibrioception equilibrioception{};
+        float pitch{0.0f};
+        float roll{0.0f};
+        // Milliseconds within the current GPS minute.
+        uint16_t time{0};
+        // Time since the GPS epoch; only set once status channel 0 provided the GPS minute.
+        bool hasGpsTime{false};
+        std::chrono::milliseconds gpsTime{0};
+        // StatusFields that changed with this packet's status channel; see status().
+        uint32_t statusChanges{0};
+        // Only set for packets with at least one valid checksum.
+        Sequence sequence{Sequence::START};
+    };
+
+    /**
+     * Counters updated while decoding; safe to be read from other threads.
+     */
+    struct Statistics {
+        std::atomic<uint64_t> packets{0};
+        std::atomic<uint64_t> invalidLength{0};
+        std::atomic<uint64_t> invalidSync{0};
+        std::atomic<uint64_t> invalidChecksum1{0};
+        std::atomic<uint64_t> invalidChecksum2{0};
+        std::atomic<uint64_t> invalidChecksum3{0};
+        // Packets rejected as a whole, i.e. without any valid batch.
+        std::atomic<uint64_t> rejected{0};
+        // Valid packets whose batches were withheld due to their navigation status.
+        std::atomic<uint64_t> gated{0};
+        // Packets skipped by the NCOM time; late packets are also counted as reordered, i.e. lost = missing - reordered.
+        std::atomic<uint64_t> missing{0};
+        std::atomic<uint64_t> duplicates{0};
+        std::atomic<uint64_t> reordered{0};
+    };
+
+    /**
+     * Output columns for decoding a batch of packets; entry i of every
+     * column belongs to packet i. Columns set to nullptr are skipped.
+     */
+    struct Columns {
+        double *latitude{nullptr};
+        double *longitude{nullptr};
+        float *altitude{nullptr};
+        float *northHeading{nullptr};
+        // 1 if position and heading of packet i passed their checksum, 0 otherwise.
+        uint8_t *valid{nullptr};
+
+        float *accelerationX{nullptr};
+        float *accelerationY{nullptr};
+        float *accelerationZ{nullptr};
+        float *angularVelocityX{nullptr};
+        float *angularVelocityY{nullptr};
+        float *angularVelocityZ{nullptr};
+        float *velocityNorth{nullptr};
+        float *velocityEast{nullptr};
+        float *velocityDown{nullptr};
+        float *pitch{nullptr};
+        float *roll{nullptr};
+    };
+
+   public:
+    // NCOM's default output rate is 100 Hz.
+    static constexpr std::chrono::milliseconds NOMINAL_PERIOD{10};
+    // Older packets are not classified as duplicate or reordered but start the sequence anew.
+    static constexpr uint32_t SEQUENCE_HISTORY{64};
+
+   public:
+    // Decodes every packet (Gating::NONE) at the nominal output rate.
     OxTSDecoder() = default;
+    /**
+     * Constructor.
+     *
+     * @param gating Handling of packets by their navigation status.
+     * @param period Time between two packets at the unit's output rate to track the sequence.
+     */
+    explicit OxTSDecoder(Gating gating, std::chrono::milliseconds period = NOMINAL_PERIOD) noexcept;
     ~OxTSDecoder() = default;
 
    public:
     std::pair<bool, std::pair<opendlv::proxy::GeodeticWgs84Reading, opendlv::proxy::GeodeticHeadingReading> >
         decode(const std::string &data) noexcept;
+
+    /**
+     * This method decodes an NCOM packet in place without copying or allocating.
+     *
+     * @param data Pointer to the first byte of the packet.
+     * @param length Number of bytes available at data.
+     * @return Pair: true if position and heading passed their checksum, and the decoded messages.
+     */
+    std::pair<bool, std::pair<opendlv::proxy::GeodeticWgs84Reading, opendlv::proxy::GeodeticHeadingReading> >
+        decode(const uint8_t *data, std::size_t length) noexcept;
+
+    /**
+     * This method validates the checksums and decodes all channels of an
+     * NCOM packet in one pass. A batch is decoded as soon as a checksum
+     * covering it has passed, so that position and heading are available
+     * even if the trailing status channel is corrupted.
+     *
+     * With Gating::LOCKED, the navigation status is checked right after
+     * the checksums and before anything is converted: Batch B is only
+     * decoded while locked and batch A additionally with raw IMU
+     * measurements; while aligning, only the status channel is decoded;
+     * invalid and trigger packets are not decoded at all.
+     *
+     * @param data Pointer to the first byte of the packet.
+     * @param length Number of bytes available at data.
+     * @param readings Decoded channels; see Readings::batches for the valid ones.
+     * @return true if at least one batch was decoded.
+     */
+    bool decode(const uint8_t *data, std::size_t length, Readings &readings) noexcept;
+
+    /**
+     * This method decodes a contiguous array of NCOM packets into
+     * structure-of-arrays columns. The 24 bit channels are extracted
+     * column-wise with the fastest SIMD kernel available on this CPU.
+     * Entries of invalid packets, including those whose navigation is
+     * withheld by Gating::LOCKED, are set to 0.
+     *
+     * @param packets Pointer to count * ncom::PACKET_LENGTH bytes.
+     * @param count Number of packets.
+     * @param columns Columns with at least count entries each.
+     * @return Number of valid packets.
+     */
+    std::size_t decodeBatch(const uint8_t *packets, std::size_t count, const Columns &columns) noexcept;
+
+    /**
+     * @return Counters for decoded and rejected packets.
+     */
+    const Statistics &statistics() const noexcept;
+
+    /**
+     * @return State assembled from the status channels decoded so far; to be read by the decoding thread.
+     */
+    const Status &status() const noexcept;
+
+   private:
+    Sequence trackSequence(uint16_t time) noexcept;
+    void decodeGpsTime(const uint8_t *data, Readings &readings) noexcept;
+    uint32_t decodeStatus(const uint8_t *data) noexcept;
+
+   private:
+    Gating m_gating{Gating::NONE};
+    int32_t m_period{static_cast<int32_t>(NOMINAL_PERIOD.count())};
+    Statistics m_statistics{};
+
+    // Newest NCOM time and the periods before it that were received (bit i: i periods earlier).
+    bool m_hasNewestTime{false};
+    uint16_t m_newestTime{0};
+    uint64_t m_receivedTimes{0};
+
+    // The GPS minute is sent in status channel 0 only and carried on in between.
+    bool m_hasGpsMinutes{false};
+    uint32_t m_gpsMinutes{0};
+    uint16_t m_previousTime{0};
+
+    // Raw bytes of each status channel as last received; unchanged channels are not decoded again.
+    std::array<uint64_t, 256> m_statusChannels{};
+    std::bitset<256> m_receivedChannels{};
+    Status m_status{};
 };
 
 #endif
-
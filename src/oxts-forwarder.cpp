@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "oxts-forwarder.hpp"
+#include "oxts-ncom.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+namespace {
+// Formatted into a fixed buffer as it is sent from the publishing path.
+opendlv::system::SignalStatusMessage gnssState(const OxTSDecoder::Status &status) noexcept {
+    std::array<char, 128> buffer;
+    std::snprintf(buffer.data(), buffer.size(), "satellites: %u, position mode: %u, velocity mode: %u, orientation mode: %u",
+                  static_cast<uint32_t>(status.satellites), static_cast<uint32_t>(status.positionMode),
+                  static_cast<uint32_t>(status.velocityMode), static_cast<uint32_t>(status.orientationMode));
+    opendlv::system::SignalStatusMessage msg;
+    msg.code(status.positionMode).description(buffer.data());
+    return msg;
+}
+
+opendlv::system::SystemOperationState navigationState(uint8_t navigationStatus) noexcept {
+    const char *description{"unknown"};
+    switch (navigationStatus) {
+        case ncom::navigation::INVALID: description = "invalid"; break;
+        case ncom::navigation::RAW_IMU: description = "raw IMU measurements"; break;
+        case ncom::navigation::INITIALISING: description = "initialising"; break;
+        case ncom::navigation::LOCKING: description = "locking"; break;
+        case ncom::navigation::LOCKED: description = "locked"; break;
+        case ncom::navigation::STATUS_ONLY: description = "status only"; break;
+        case ncom::navigation::TRIGGER_INITIALISING:
+        case ncom::navigation::TRIGGER_LOCKING:
+        case ncom::navigation::TRIGGER_LOCKED: description = "trigger"; break;
+        default: break;
+    }
+    opendlv::system::SystemOperationState msg;
+    msg.code(navigationStatus).description(description);
+    return msg;
+}
+
+opendlv::body::SensorInfo sensorInfo(const std::string &description, uint32_t signalId) {
+    opendlv::body::SensorInfo info;
+    info.description(description).signalId(signalId);
+    return info;
+}
+
+float horizontal(const std::array<float, 3> &northEastDown) noexcept {
+    return std::hypot(northEastDown[0], northEastDown[1]);
+}
+} // namespace
+
+constexpr std::chrono::seconds OxTSForwarder::STATUS_INTERVAL;
+
+OxTSForwarder::OxTSForwarder(od4::Publisher &publisher, cluon::OD4Session &od4, uint32_t senderStamp) noexcept
+    : m_publisher(publisher)
+    , m_od4(od4)
+    , m_senderStamp(senderStamp)
+    , m_positionInfo(sensorInfo("position", opendlv::proxy::GeodeticWgs84Reading::ID()))
+    , m_altitudeInfo(sensorInfo("altitude", opendlv::proxy::AltitudeReading::ID()))
+    , m_headingInfo(sensorInfo("heading", opendlv::proxy::GeodeticHeadingReading::ID()))
+    , m_velocityInfo(sensorInfo("velocity", opendlv::logic::sensation::Equilibrioception::ID())) {}
+
+bool OxTSForwarder::forward(const OxTSDecoder::Readings &readings,
+                            const OxTSDecoder::Status &status,
+                            const cluon::data::TimeStamp &sampleTime,
+                            const std::chrono::system_clock::time_point &now,
+                            stages::Marks *marks) noexcept {
+    // Position and attitude are published even if the trailing status channel is corrupted.
+    const bool HAS_NAVIGATION{0 != (readings.batches & OxTSDecoder::BATCH_B)};
+    if (HAS_NAVIGATION) {
+        m_publisher.queue(readings.position, sampleTime, m_senderStamp);
+        m_publisher.queue(readings.heading, sampleTime, m_senderStamp);
+        m_publisher.queue(readings.altitude, sampleTime, m_senderStamp);
+        m_publisher.queue(readings.equilibrioception, sampleTime, m_senderStamp);
+
+        if (0 != (status.valid & OxTSDecoder::POSITION_ACCURACY)) {
+            m_publisher.queue(m_positionInfo.accuracyStd(horizontal(status.positionAccuracy)), sampleTime, m_senderStamp);
+            m_publisher.queue(m_altitudeInfo.accuracyStd(status.positionAccuracy[2]), sampleTime, m_senderStamp);
+        }
+        if (0 != (status.valid & OxTSDecoder::ORIENTATION_ACCURACY)) {
+            m_publisher.queue(m_headingInfo.accuracyStd(status.orientationAccuracy[0]), sampleTime, m_senderStamp);
+        }
+        if (0 != (status.valid & OxTSDecoder::VELOCITY_ACCURACY)) {
+            const float SPEED_ACCURACY{std::hypot(horizontal(status.velocityAccuracy), status.velocityAccuracy[2])};
+            m_publisher.queue(m_velocityInfo.accuracyStd(SPEED_ACCURACY), sampleTime, m_senderStamp);
+        }
+    }
+
+    // IMU measurements are withheld together with the navigation while the unit is aligning.
+    const bool HAS_IMU{0 != (readings.batches & OxTSDecoder::BATCH_A)};
+    if (HAS_IMU) {
+        m_publisher.queue(readings.acceleration, sampleTime, m_senderStamp);
+        m_publisher.queue(readings.angularVelocity, sampleTime, m_senderStamp);
+    }
+
+    if (nullptr != marks) {
+        marks->serializeEnd = stages::now();
+    }
+    m_publisher.flush();
+
+    // Rare enough to be sent through the regular session.
+    const bool IS_STATUS_DUE{(now < m_statusSent) || (STATUS_INTERVAL <= now - m_statusSent)};
+    if ( (0 != (status.valid & OxTSDecoder::NAVIGATION_STATUS))
+         && ((0 != (readings.statusChanges & OxTSDecoder::NAVIGATION_STATUS)) || IS_STATUS_DUE) ) {
+        opendlv::system::SystemOperationState state{navigationState(status.navigationStatus)};
+        m_od4.send(state, sampleTime, m_senderStamp);
+    }
+    if ( (0 != (status.valid & OxTSDecoder::GNSS_STATE))
+         && ((0 != (readings.statusChanges & OxTSDecoder::GNSS_STATE)) || IS_STATUS_DUE) ) {
+        opendlv::system::SignalStatusMessage state{gnssState(status)};
+        m_od4.send(state, sampleTime, m_senderStamp);
+    }
+    if (IS_STATUS_DUE) {
+        m_statusSent = now;
+    }
+    return HAS_NAVIGATION || HAS_IMU;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_FORWARDER
+#define OXTS_FORWARDER
+
+#include "cluon-complete.hpp"
+#include "opendlv-standard-message-set.hpp"
+
+#include "oxts-decoder.hpp"
+#include "oxts-publisher.hpp"
+#include "oxts-stages.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Publishes the decoded packets of one unit: Navigation and IMU readings
+ * together with the unit's accuracies are encoded into the Publisher's
+ * preencoded frames and sent at once; the navigation and GNSS state are sent through the
+ * OD4Session whenever they change and repeated once per STATUS_INTERVAL.
+ *
+ * Not thread-safe: Use from the thread that owns the Publisher.
+ */
+class OxTSForwarder {
+   private:
+    OxTSForwarder(const OxTSForwarder &) = delete;
+    OxTSForwarder(OxTSForwarder &&)      = delete;
+    OxTSForwarder &operator=(const OxTSForwarder &) = delete;
+    OxTSForwarder &operator=(OxTSForwarder &&) = delete;
+
+   public:
+    static constexpr std::chrono::seconds STATUS_INTERVAL{1};
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param publisher Publisher for the readings.
+     * @param od4 Session for the rarely sent state messages.
+     * @param senderStamp senderStamp of all messages.
+     */
+    OxTSForwarder(od4::Publisher &publisher, cluon::OD4Session &od4, uint32_t senderStamp) noexcept;
+    ~OxTSForwarder() = default;
+
+    /**
+     * This method publishes the batches of a decoded packet.
+     *
+     * @param readings Readings of the packet.
+     * @param status Decoder's status after decoding the packet.
+     * @param sampleTime Time stamp of the readings (default = sent time point).
+     * @param now Time to schedule the repeated state messages.
+     * @param marks Optional time points to store the end of encoding into.
+     * @return true if any readings were published.
+     */
+    bool forward(const OxTSDecoder::Readings &readings,
+                 const OxTSDecoder::Status &status,
+                 const cluon::data::TimeStamp &sampleTime,
+                 const std::chrono::system_clock::time_point &now,
+                 stages::Marks *marks = nullptr) noexcept;
+
+   private:
+    od4::Publisher &m_publisher;
+    cluon::OD4Session &m_od4;
+    const uint32_t m_senderStamp;
+
+    // Standard deviations accompany every fix; signalId refers to the qualified message.
+    opendlv::body::SensorInfo m_positionInfo{};
+    opendlv::body::SensorInfo m_altitudeInfo{};
+    opendlv::body::SensorInfo m_headingInfo{};
+    opendlv::body::SensorInfo m_velocityInfo{};
+
+    std::chrono::system_clock::time_point m_statusSent{};
+};
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "oxts-framer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+OxTSFramer::OxTSFramer(Delegate delegate) noexcept
+    : m_delegate(std::move(delegate)) {}
+
+const OxTSFramer::Statistics &OxTSFramer::statistics() const noexcept {
+    return m_statistics;
+}
+
+void OxTSFramer::resynchronizePending() noexcept {
+    const uint8_t *next{(1 < m_pendingLength)
+        ? static_cast<const uint8_t *>(std::memchr(m_pending.data() + 1, ncom::SYNC, m_pendingLength - 1))
+        : nullptr};
+    const std::size_t DROPPED{(nullptr == next) ? m_pendingLength : static_cast<std::size_t>(next - m_pending.data())};
+    std::memmove(m_pending.data(), m_pending.data() + DROPPED, m_pendingLength - DROPPED);
+    m_pendingLength -= DROPPED;
+    m_statistics.skipped += DROPPED;
+}
+
+void OxTSFramer::push(const uint8_t *data, std::size_t length) noexcept {
+    if ( (nullptr == data) || (0 == length) ) {
+        return;
+    }
+    const uint8_t *end{data + length};
+
+    // Complete a frame from the previous chunk first.
+    while (0 < m_pendingLength) {
+        const std::size_t MISSING{std::min(ncom::PACKET_LENGTH - m_pendingLength, static_cast<std::size_t>(end - data))};
+        std::memcpy(m_pending.data() + m_pendingLength, data, MISSING);
+        m_pendingLength += MISSING;
+        data += MISSING;
+        if (ncom::PACKET_LENGTH > m_pendingLength) {
+            return;
+        }
+
+        if (ncom::isFramed(m_pending.data())) {
+            m_pendingLength = 0;
+            m_statistics.frames++;
+            m_delegate(m_pending.data(), ncom::PACKET_LENGTH);
+        } else {
+            resynchronizePending();
+        }
+    }
+
+    // Frames within this chunk are handed over in place.
+    while (data < end) {
+        const uint8_t *sync{static_cast<const uint8_t *>(std::memchr(data, ncom::SYNC, static_cast<std::size_t>(end - data)))};
+        if (nullptr == sync) {
+            m_statistics.skipped += static_cast<uint64_t>(end - data);
+            break;
+        }
+        m_statistics.skipped += static_cast<uint64_t>(sync - data);
+        data = sync;
+
+        if (ncom::PACKET_LENGTH > static_cast<std::size_t>(end - data)) {
+            // Carry the beginning of a frame over to the next chunk.
+            m_pendingLength = static_cast<std::size_t>(end - data);
+            std::memcpy(m_pending.data(), data, m_pendingLength);
+            break;
+        }
+        if (ncom::isFramed(data)) {
+            m_statistics.frames++;
+            m_delegate(data, ncom::PACKET_LENGTH);
+            data += ncom::PACKET_LENGTH;
+        } else {
+            m_statistics.skipped++;
+            data++;
+        }
+    }
+}
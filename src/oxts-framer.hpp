@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_FRAMER
+#define OXTS_FRAMER
+
+#include "oxts-ncom.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <functional>
+
+/**
+ * Incremental framer for NCOM byte streams such as serial ports, TCP
+ * connections, or concatenated files: Bytes are pushed in chunks of any
+ * size; sync bytes are searched with memchr and frames are confirmed by
+ * their checksums (see ncom::isFramed). Frames that lie within a chunk are
+ * handed to the delegate in place; only a frame split across two chunks is
+ * assembled from the few bytes carried over from the previous chunk.
+ *
+ * After corrupted bytes, the search continues right after the rejected
+ * sync byte, so that framing recovers with the next intact frame.
+ *
+ * Not thread-safe: push() is meant to be called from a single thread.
+ */
+class OxTSFramer {
+   private:
+    OxTSFramer(const OxTSFramer &) = delete;
+    OxTSFramer(OxTSFramer &&)      = delete;
+    OxTSFramer &operator=(const OxTSFramer &) = delete;
+    OxTSFramer &operator=(OxTSFramer &&) = delete;
+
+   public:
+    /**
+     * Delegate to handle a frame; data is only valid during the call.
+     * Parameters are the first byte of the frame and its length.
+     */
+    using Delegate = std::function<void(const uint8_t *, std::size_t)>;
+
+    struct Statistics {
+        uint64_t frames{0};
+        // Bytes that did not belong to any frame.
+        uint64_t skipped{0};
+    };
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param delegate Function to be called for every complete frame.
+     */
+    explicit OxTSFramer(Delegate delegate) noexcept;
+    ~OxTSFramer() = default;
+
+    /**
+     * This method frames the next chunk of the stream.
+     *
+     * @param data Pointer to the received bytes.
+     * @param length Number of received bytes.
+     */
+    void push(const uint8_t *data, std::size_t length) noexcept;
+
+    /**
+     * @return Counters for frames and skipped bytes.
+     */
+    const Statistics &statistics() const noexcept;
+
+   private:
+    // Drops leading bytes of the carried over bytes up to the next sync byte after the first one.
+    void resynchronizePending() noexcept;
+
+   private:
+    Delegate m_delegate;
+    Statistics m_statistics{};
+
+    // Beginning of a frame that continues in the next chunk; starts with a sync byte.
+    std::array<uint8_t, ncom::PACKET_LENGTH> m_pending{};
+    std::size_t m_pendingLength{0};
+};
+
+#endif
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "oxts-health.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstdio>
+
+namespace {
+int32_t toCode(uint64_t count) noexcept {
+    return static_cast<int32_t>(std::min<uint64_t>(count, INT32_MAX));
+}
+} // namespace
+
+constexpr uint32_t OxTSHealthPublisher::SENDER_STAMP_OFFSET;
+
+OxTSHealthPublisher::OxTSHealthPublisher(cluon::OD4Session &od4,
+                                         const std::vector<const OxTSDecoder *> &decoders,
+                                         const std::vector<uint32_t> &senderStamps,
+                                         const LatencyHistogram &latency,
+                                         std::chrono::milliseconds interval) noexcept
+    : m_od4(od4)
+    , m_units(std::min(decoders.size(), senderStamps.size()))
+    , m_latency(latency)
+    , m_interval(interval) {
+    for (std::size_t i{0}; i < m_units.size(); i++) {
+        m_units[i].decoder     = decoders[i];
+        m_units[i].senderStamp = senderStamps[i] + SENDER_STAMP_OFFSET;
+    }
+}
+
+void OxTSHealthPublisher::watch(const OxTSReceiver &receiver) noexcept {
+    m_receiver.store(&receiver);
+}
+
+void OxTSHealthPublisher::watch(const spsc::Statistics &queue) noexcept {
+    m_queue.store(&queue);
+}
+
+bool OxTSHealthPublisher::publish(std::chrono::steady_clock::time_point now) noexcept {
+    const bool IS_DUE{(0 < m_interval.count())
+                      && ((std::chrono::steady_clock::time_point{} == m_published) || (m_interval <= now - m_published))};
+    if (IS_DUE) {
+        const double SECONDS{(std::chrono::steady_clock::time_point{} == m_published) ? 0.0 : std::chrono::duration<double>(now - m_published).count()};
+        m_published = now;
+
+        // The queue is shared by all units.
+        const spsc::Statistics *queue{m_queue.load()};
+        const uint64_t QUEUE_DROPS{(nullptr == queue) ? 0 : queue->dropped.load(std::memory_order_relaxed)};
+        const bool IS_QUEUE_DROPPING{QUEUE_DROPS > m_previousQueueDrops};
+        m_previousQueueDrops = QUEUE_DROPS;
+
+        for (uint32_t unit{0}; unit < m_units.size(); unit++) {
+            opendlv::system::NetworkStatusMessage network{networkStatus(unit, SECONDS, QUEUE_DROPS, IS_QUEUE_DROPPING)};
+            m_od4.send(network, cluon::data::TimeStamp{}, m_units[unit].senderStamp);
+            opendlv::system::SignalStatusMessage signal{signalStatus(unit)};
+            m_od4.send(signal, cluon::data::TimeStamp{}, m_units[unit].senderStamp);
+        }
+    }
+    return IS_DUE;
+}
+
+opendlv::system::NetworkStatusMessage OxTSHealthPublisher::networkStatus(uint32_t unit, double seconds, uint64_t queueDrops, bool isQueueDropping) noexcept {
+    Unit &u = m_units[unit];
+    const uint64_t PACKETS{u.decoder->statistics().packets.load(std::memory_order_relaxed)};
+    const OxTSReceiver *receiver{m_receiver.load()};
+    const uint64_t KERNEL_DROPS{(nullptr == receiver) ? 0 : receiver->kernelDrops(unit)};
+    const uint64_t MISSING{u.decoder->statistics().missing.load(std::memory_order_relaxed)};
+    const double RATE{(0.0 < seconds) ? static_cast<double>(PACKETS - u.previousPackets) / seconds : 0.0};
+
+    int32_t code{RECEIVING};
+    if (isQueueDropping || (KERNEL_DROPS != u.previousKernelDrops) || (MISSING != u.previousMissing)) {
+        code = DROPPING;
+    } else if (PACKETS == u.previousPackets) {
+        code = SILENT;
+    }
+    u.previousPackets     = PACKETS;
+    u.previousKernelDrops = KERNEL_DROPS;
+    u.previousMissing     = MISSING;
+
+    std::array<char, 256> buffer;
+    std::snprintf(buffer.data(), buffer.size(),
+                  "rate: %.1f packets/s, packets: %" PRIu64 ", kernel drops: %" PRIu64 ", queue drops (all units): %" PRIu64
+                  ", missing: %" PRIu64 ", duplicates: %" PRIu64 ", reordered: %" PRIu64,
+                  RATE, PACKETS, KERNEL_DROPS, queueDrops, MISSING,
+                  static_cast<uint64_t>(u.decoder->statistics().duplicates.load(std::memory_order_relaxed)),
+                  static_cast<uint64_t>(u.decoder->statistics().reordered.load(std::memory_order_relaxed)));
+    opendlv::system::NetworkStatusMessage msg;
+    msg.code(code).description(buffer.data());
+    return msg;
+}
+
+opendlv::system::SignalStatusMessage OxTSHealthPublisher::signalStatus(uint32_t unit) noexcept {
+    Unit &u = m_units[unit];
+    const OxTSDecoder::Statistics &s{u.decoder->statistics()};
+    const uint64_t REJECTED{s.rejected.load(std::memory_order_relaxed)};
+    const int32_t CODE{toCode(REJECTED - u.previousRejected)};
+    u.previousRejected = REJECTED;
+
+    std::array<char, 256> buffer;
+    std::snprintf(buffer.data(), buffer.size(),
+                  "rejected: %" PRIu64 " (length: %" PRIu64 ", sync: %" PRIu64 ", checksum 1/2/3: %" PRIu64 "/%" PRIu64 "/%" PRIu64
+                  "), navigation: %" PRIu64 ", latency p99: %" PRId64 " us",
+                  REJECTED,
+                  static_cast<uint64_t>(s.invalidLength.load(std::memory_order_relaxed)),
+                  static_cast<uint64_t>(s.invalidSync.load(std::memory_order_relaxed)),
+                  static_cast<uint64_t>(s.invalidChecksum1.load(std::memory_order_relaxed)),
+                  static_cast<uint64_t>(s.invalidChecksum2.load(std::memory_order_relaxed)),
+                  static_cast<uint64_t>(s.invalidChecksum3.load(std::memory_order_relaxed)),
+                  static_cast<uint64_t>(s.gated.load(std::memory_order_relaxed)),
+                  static_cast<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(m_latency.percentile(99.0)).count()));
+    opendlv::system::SignalStatusMessage msg;
+    msg.code(CODE).description(buffer.data());
+    return msg;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_HEALTH
+#define OXTS_HEALTH
+
+#include "cluon-complete.hpp"
+#include "opendlv-standard-message-set.hpp"
+
+#include "oxts-decoder.hpp"
+#include "oxts-latency.hpp"
+#include "oxts-receiver.hpp"
+#include "oxts-spsc-ring.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Publishes the health of every unit to the OD4 session so that it is visible
+ * on the bus: An opendlv.system.NetworkStatusMessage describes the input
+ * (packet rate, kernel and queue drops, gaps in the sequence) and an opendlv.system.SignalStatusMessage
+ * the decoding (rejects by reason and the p99 latency). Both are sent with the
+ * unit's senderStamp plus SENDER_STAMP_OFFSET, as the unit's own
+ * SignalStatusMessage carries its GNSS state with a differently meant code.
+ *
+ * All figures are read from counters that the receiving and publishing threads
+ * update with relaxed atomics; publish() is meant to be called periodically
+ * from a single thread that is neither of them.
+ */
+class OxTSHealthPublisher {
+   private:
+    OxTSHealthPublisher(const OxTSHealthPublisher &) = delete;
+    OxTSHealthPublisher(OxTSHealthPublisher &&)      = delete;
+    OxTSHealthPublisher &operator=(const OxTSHealthPublisher &) = delete;
+    OxTSHealthPublisher &operator=(OxTSHealthPublisher &&) = delete;
+
+   public:
+    // Added to a unit's senderStamp to tell its health from its readings and state.
+    static constexpr uint32_t SENDER_STAMP_OFFSET{1000};
+
+    /**
+     * Codes of the NetworkStatusMessage; the SignalStatusMessage's code is
+     * the number of packets rejected since the previous message.
+     */
+    enum Network : int32_t {
+        RECEIVING = 0, // Packets arrived and none were dropped since the previous message.
+        SILENT    = 1, // No packets arrived since the previous message.
+        DROPPING  = 2, // Packets were dropped by the kernel or the queue, or are missing from the sequence, since the previous message.
+    };
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param od4 Session to send the messages to.
+     * @param decoders Decoders of the units; index i is the unit of receiver endpoint i.
+     * @param senderStamps senderStamp per unit; the messages are sent with SENDER_STAMP_OFFSET added.
+     * @param latency Histogram of socket-to-publish latencies.
+     * @param interval Time between two messages per unit; 0 disables publishing.
+     */
+    OxTSHealthPublisher(cluon::OD4Session &od4,
+                        const std::vector<const OxTSDecoder *> &decoders,
+                        const std::vector<uint32_t> &senderStamps,
+                        const LatencyHistogram &latency,
+                        std::chrono::milliseconds interval) noexcept;
+    ~OxTSHealthPublisher() = default;
+
+    /**
+     * This method adds the kernel drops per unit to the messages.
+     *
+     * @param receiver Receiver that outlives this publisher.
+     */
+    void watch(const OxTSReceiver &receiver) noexcept;
+
+    /**
+     * This method adds the drops of the queue shared by all units to the messages.
+     *
+     * @param queue Counters of a queue that outlives this publisher.
+     */
+    void watch(const spsc::Statistics &queue) noexcept;
+
+    /**
+     * This method sends the messages of all units if the interval has elapsed.
+     *
+     * @param now Current time.
+     * @return true if the messages were sent.
+     */
+    bool publish(std::chrono::steady_clock::time_point now) noexcept;
+
+   private:
+    struct Unit {
+        const OxTSDecoder *decoder{nullptr};
+        uint32_t senderStamp{0};
+        uint64_t previousPackets{0};
+        uint64_t previousRejected{0};
+        uint64_t previousKernelDrops{0};
+        uint64_t previousMissing{0};
+    };
+
+    opendlv::system::NetworkStatusMessage networkStatus(uint32_t unit, double seconds, uint64_t queueDrops, bool isQueueDropping) noexcept;
+    opendlv::system::SignalStatusMessage signalStatus(uint32_t unit) noexcept;
+
+   private:
+    cluon::OD4Session &m_od4;
+    std::vector<Unit> m_units;
+    const LatencyHistogram &m_latency;
+    const std::chrono::milliseconds m_interval;
+
+    std::atomic<const OxTSReceiver *> m_receiver{nullptr};
+    std::atomic<const spsc::Statistics *> m_queue{nullptr};
+    uint64_t m_previousQueueDrops{0};
+    std::chrono::steady_clock::time_point m_published{};
+};
+
+#endif
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "oxts-kernels.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <array>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define OXTS_KERNELS_X86
+    #include <immintrin.h>
+#endif
+
+namespace ncom {
+
+namespace {
+void extractScalar(const uint8_t *packets, std::size_t count, const Channel24 &channel, float *out) noexcept {
+    for (std::size_t i{0}; i < count; i++) {
+        const uint8_t *p{packets + i * PACKET_LENGTH + channel.offset};
+        const float value{(channel.isSigned ? static_cast<float>(detail::Reader<int32_t, 3>::read(p))
+                                            : static_cast<float>(detail::Reader<uint32_t, 3>::read(p)))
+                          * channel.scale};
+        out[i] = (channel.isAngle ? normalizeAngle(value) : value);
+    }
+}
+
+#ifdef OXTS_KERNELS_X86
+// Vector versions of normalizeAngle().
+#ifdef __SSE2__
+inline __m128 normalizeSSE2(__m128 x) noexcept {
+    const __m128 PI{_mm_set1_ps(PI_BELOW)};
+    const __m128 MINUS_PI{_mm_set1_ps(-PI_BELOW)};
+    const __m128 TWO_PI_{_mm_set1_ps(TWO_PI)};
+    for (uint32_t i{0}; i < NORMALIZATION_STEPS; i++) {
+        x = _mm_add_ps(x, _mm_and_ps(_mm_cmplt_ps(x, MINUS_PI), TWO_PI_));
+    }
+    for (uint32_t i{0}; i < NORMALIZATION_STEPS; i++) {
+        x = _mm_sub_ps(x, _mm_and_ps(_mm_cmpgt_ps(x, PI), TWO_PI_));
+    }
+    return x;
+}
+
+void extractSSE2(const uint8_t *packets, std::size_t count, const Channel24 &channel, float *out) noexcept {
+    const __m128 SCALE{_mm_set1_ps(channel.scale)};
+    const __m128i MASK{_mm_set1_epi32(0x00FFFFFF)};
+
+    std::size_t i{0};
+    for (; i + 4 <= count; i += 4) {
+        const uint8_t *p{packets + i * PACKET_LENGTH + channel.offset};
+        // Load four bytes per packet; the fourth byte is masked or shifted out.
+        std::array<int32_t, 4> lanes;
+        for (uint32_t lane{0}; lane < 4; lane++) {
+            std::memcpy(&lanes[lane], p + lane * PACKET_LENGTH, sizeof(int32_t));
+        }
+        __m128i raw{_mm_loadu_si128(reinterpret_cast<const __m128i *>(lanes.data()))};
+        raw = (channel.isSigned ? _mm_srai_epi32(_mm_slli_epi32(raw, 8), 8) : _mm_and_si128(raw, MASK));
+
+        __m128 value{_mm_mul_ps(_mm_cvtepi32_ps(raw), SCALE)};
+        if (channel.isAngle) {
+            value = normalizeSSE2(value);
+        }
+        _mm_storeu_ps(out + i, value);
+    }
+    extractScalar(packets + i * PACKET_LENGTH, count - i, channel, out + i);
+}
+#endif
+
+__attribute__((target("avx2"))) inline __m256 normalizeAVX2(__m256 x) noexcept {
+    const __m256 PI{_mm256_set1_ps(PI_BELOW)};
+    const __m256 MINUS_PI{_mm256_set1_ps(-PI_BELOW)};
+    const __m256 TWO_PI_{_mm256_set1_ps(TWO_PI)};
+    for (uint32_t i{0}; i < NORMALIZATION_STEPS; i++) {
+        x = _mm256_add_ps(x, _mm256_and_ps(_mm256_cmp_ps(x, MINUS_PI, _CMP_LT_OQ), TWO_PI_));
+    }
+    for (uint32_t i{0}; i < NORMALIZATION_STEPS; i++) {
+        x = _mm256_sub_ps(x, _mm256_and_ps(_mm256_cmp_ps(x, PI, _CMP_GT_OQ), TWO_PI_));
+    }
+    return x;
+}
+
+__attribute__((target("avx2"))) void extractAVX2(const uint8_t *packets,
+                                                 std::size_t count,
+                                                 const Channel24 &channel,
+                                                 float *out) noexcept {
+    constexpr int32_t L{static_cast<int32_t>(PACKET_LENGTH)};
+    const __m256i INDEX{_mm256_setr_epi32(0, L, 2 * L, 3 * L, 4 * L, 5 * L, 6 * L, 7 * L)};
+    const __m256 SCALE{_mm256_set1_ps(channel.scale)};
+    const __m256i MASK{_mm256_set1_epi32(0x00FFFFFF)};
+
+    std::size_t i{0};
+    for (; i + 8 <= count; i += 8) {
+        const uint8_t *p{packets + i * PACKET_LENGTH + channel.offset};
+        // Gather four bytes per packet; the fourth byte is masked or shifted out.
+        __m256i raw{_mm256_i32gather_epi32(reinterpret_cast<const int *>(p), INDEX, 1)};
+        raw = (channel.isSigned ? _mm256_srai_epi32(_mm256_slli_epi32(raw, 8), 8) : _mm256_and_si256(raw, MASK));
+
+        __m256 value{_mm256_mul_ps(_mm256_cvtepi32_ps(raw), SCALE)};
+        if (channel.isAngle) {
+            value = normalizeAVX2(value);
+        }
+        _mm256_storeu_ps(out + i, value);
+    }
+    extractScalar(packets + i * PACKET_LENGTH, count - i, channel, out + i);
+}
+#endif
+} // namespace
+
+bool isSupported(Kernel kernel) noexcept {
+    bool retVal{false};
+    switch (kernel) {
+        case Kernel::SCALAR: retVal = true; break;
+#if defined(OXTS_KERNELS_X86) && defined(__SSE2__)
+        case Kernel::SSE2: retVal = true; break;
+#endif
+#ifdef OXTS_KERNELS_X86
+        case Kernel::AVX2: retVal = (0 != __builtin_cpu_supports("avx2")); break;
+#endif
+        default: break;
+    }
+    return retVal;
+}
+
+Kernel bestKernel() noexcept {
+    static const Kernel BEST{isSupported(Kernel::AVX2) ? Kernel::AVX2
+                                                         : (isSupported(Kernel::SSE2) ? Kernel::SSE2 : Kernel::SCALAR)};
+    return BEST;
+}
+
+const char *name(Kernel kernel) noexcept {
+    const char *retVal{"scalar"};
+    if (Kernel::SSE2 == kernel) {
+        retVal = "sse2";
+    } else if (Kernel::AVX2 == kernel) {
+        retVal = "avx2";
+    }
+    return retVal;
+}
+
+void extract24(Kernel kernel, const uint8_t *packets, std::size_t count, const Channel24 &channel, float *out) noexcept {
+    if ( (nullptr == packets) || (nullptr == out) || (channel.offset + sizeof(uint32_t) > PACKET_LENGTH) ) {
+        return;
+    }
+    if (!isSupported(kernel)) {
+        kernel = Kernel::SCALAR;
+    }
+    switch (kernel) {
+#if defined(OXTS_KERNELS_X86) && defined(__SSE2__)
+        case Kernel::SSE2: extractSSE2(packets, count, channel, out); break;
+#endif
+#ifdef OXTS_KERNELS_X86
+        case Kernel::AVX2: extractAVX2(packets, count, channel, out); break;
+#endif
+        default: extractScalar(packets, count, channel, out); break;
+    }
+}
+
+} // namespace ncom
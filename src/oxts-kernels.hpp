@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_KERNELS
+#define OXTS_KERNELS
+
+#include "oxts-ncom.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Column-wise extraction of 24 bit fixed-point channels from arrays of
+ * consecutive NCOM packets. The results are bit-exact to ncom::value<F>()
+ * (followed by ncom::normalizeAngle() for angles) for every kernel.
+ */
+namespace ncom {
+
+enum class Kernel : uint8_t {
+    SCALAR,
+    SSE2, // 4 packets at a time.
+    AVX2, // 8 packets at a time using gathers.
+};
+
+/**
+ * @return true if the given kernel can be executed on this CPU.
+ */
+bool isSupported(Kernel kernel) noexcept;
+
+/**
+ * @return Fastest kernel supported by this CPU; determined once at runtime.
+ */
+Kernel bestKernel() noexcept;
+
+/**
+ * @return Human-readable name of the given kernel.
+ */
+const char *name(Kernel kernel) noexcept;
+
+/**
+ * Location and representation of a 24 bit channel within a packet.
+ */
+struct Channel24 {
+    std::size_t offset;
+    bool isSigned;
+    float scale;
+    // true if the result shall be normalized between -M_PI .. M_PI.
+    bool isAngle;
+};
+
+/**
+ * @return Description of the 24 bit channel FIELD.
+ */
+template <typename FIELD>
+constexpr Channel24 channel24(bool isAngle = false) noexcept {
+    static_assert(3 == FIELD::WIDTH, "Only 24 bit channels are supported.");
+    static_assert(FIELD::OFFSET + sizeof(uint32_t) <= PACKET_LENGTH, "Kernels load four bytes per channel.");
+    return Channel24{FIELD::OFFSET, std::is_signed<typename FIELD::raw_type>::value, FIELD::scale(), isAngle};
+}
+
+/**
+ * This function extracts, sign-extends (if signed), scales, and optionally
+ * normalizes a 24 bit channel from count consecutive packets.
+ *
+ * @param kernel Kernel to use; unsupported kernels fall back to SCALAR.
+ * @param packets Pointer to count * PACKET_LENGTH bytes.
+ * @param count Number of packets.
+ * @param channel Channel to extract.
+ * @param out Destination for count values.
+ */
+void extract24(Kernel kernel, const uint8_t *packets, std::size_t count, const Channel24 &channel, float *out) noexcept;
+
+/**
+ * This function extracts a 24 bit channel using bestKernel().
+ */
+inline void extract24(const uint8_t *packets, std::size_t count, const Channel24 &channel, float *out) noexcept {
+    extract24(bestKernel(), packets, count, channel, out);
+}
+
+} // namespace ncom
+
+#endif
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_LATENCY
+#define OXTS_LATENCY
+
+#include "oxts-counters.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Histogram of latencies with logarithmic buckets that are subdivided
+ * linearly (similar to HdrHistogram): Every bucket is at most 1/16 of its
+ * lower bound wide, i.e., percentiles are accurate to about 6 %.
+ *
+ * record() is meant to be called from a single thread and does neither
+ * allocate nor lock; all other methods may be called concurrently.
+ */
+class LatencyHistogram {
+   private:
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram(LatencyHistogram &&)      = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(LatencyHistogram &&) = delete;
+
+   public:
+    LatencyHistogram() = default;
+
+    /**
+     * This method adds a latency; negative latencies are counted as 0.
+     *
+     * @param latency Latency to add.
+     */
+    void record(std::chrono::nanoseconds latency) noexcept {
+        const uint64_t NS{(0 > latency.count()) ? 0 : static_cast<uint64_t>(latency.count())};
+        counters::increment(m_buckets[bucketOf(NS)]);
+        counters::increment(m_count);
+        if (NS > m_max.load(std::memory_order_relaxed)) {
+            m_max.store(NS, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @return Number of recorded latencies.
+     */
+    uint64_t count() const noexcept {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @return Largest recorded latency.
+     */
+    std::chrono::nanoseconds max() const noexcept {
+        return std::chrono::nanoseconds{static_cast<int64_t>(m_max.load(std::memory_order_relaxed))};
+    }
+
+    /**
+     * @param p Percentile between 0 .. 100.
+     * @return Upper bound of the bucket containing the given percentile; 0 if empty.
+     */
+    std::chrono::nanoseconds percentile(double p) const noexcept {
+        uint64_t total{0};
+        for (const auto &b : m_buckets) {
+            total += b.load(std::memory_order_relaxed);
+        }
+        uint64_t retVal{0};
+        if (0 < total) {
+            const double clamped{(p < 0.0) ? 0.0 : ((p > 100.0) ? 100.0 : p)};
+            uint64_t rank{static_cast<uint64_t>(clamped / 100.0 * static_cast<double>(total) + 0.5)};
+            rank = (0 == rank) ? 1 : rank;
+            uint64_t seen{0};
+            for (std::size_t i{0}; i < BUCKETS; i++) {
+                seen += m_buckets[i].load(std::memory_order_relaxed);
+                if (seen >= rank) {
+                    retVal = upperBoundOf(i);
+                    break;
+                }
+            }
+            const uint64_t MAX{m_max.load(std::memory_order_relaxed)};
+            retVal = (retVal > MAX) ? MAX : retVal;
+        }
+        return std::chrono::nanoseconds{static_cast<int64_t>(retVal)};
+    }
+
+    /**
+     * This method clears all recorded latencies. It must not race with record().
+     */
+    void reset() noexcept {
+        for (auto &b : m_buckets) {
+            b.store(0, std::memory_order_relaxed);
+        }
+        m_count.store(0, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+   public:
+    // Values below 2^SUB_BITS are counted exactly.
+    static constexpr uint32_t SUB_BITS{4};
+    static constexpr uint64_t SUB_BUCKETS{1u << SUB_BITS};
+    // Latencies of 2^MAX_EXPONENT ns (about 18 minutes) and more share the last bucket.
+    static constexpr uint32_t MAX_EXPONENT{40};
+    static constexpr std::size_t BUCKETS{SUB_BUCKETS + (MAX_EXPONENT - SUB_BITS) * SUB_BUCKETS};
+
+    /**
+     * @return Index of the bucket for the given latency in ns.
+     */
+    static std::size_t bucketOf(uint64_t ns) noexcept {
+        std::size_t retVal{0};
+        if (ns < SUB_BUCKETS) {
+            retVal = static_cast<std::size_t>(ns);
+        } else {
+            const uint32_t EXPONENT{63u - static_cast<uint32_t>(__builtin_clzll(ns))};
+            if (EXPONENT >= MAX_EXPONENT) {
+                retVal = BUCKETS - 1;
+            } else {
+                const uint64_t SUB{(ns >> (EXPONENT - SUB_BITS)) & (SUB_BUCKETS - 1)};
+                retVal = static_cast<std::size_t>(SUB_BUCKETS + (EXPONENT - SUB_BITS) * SUB_BUCKETS + SUB);
+            }
+        }
+        return retVal;
+    }
+
+    /**
+     * @return Largest latency in ns that falls into the given bucket.
+     */
+    static uint64_t upperBoundOf(std::size_t bucket) noexcept {
+        uint64_t retVal{bucket};
+        if (bucket >= SUB_BUCKETS) {
+            const uint64_t EXPONENT{(bucket - SUB_BUCKETS) / SUB_BUCKETS + SUB_BITS};
+            const uint64_t SUB{(bucket - SUB_BUCKETS) % SUB_BUCKETS};
+            retVal = ((SUB_BUCKETS + SUB + 1) << (EXPONENT - SUB_BITS)) - 1;
+        }
+        return retVal;
+    }
+
+   private:
+    std::array<std::atomic<uint64_t>, BUCKETS> m_buckets{};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_max{0};
+};
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_LEGACY
+#define OXTS_LEGACY
+
+#include <endian.h>
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Reference data shared by the tests and oxts-bench: a packet as sent by a
+ * locked unit and the stream-based decoder as originally shipped, against
+ * which the current decoder is checked and measured.
+ */
+namespace legacy {
+
+// Packet as sent by a locked unit.
+const std::vector<uint8_t> SAMPLE{
+  0xe7, 0x9c, 0x95, 0x95, 0x08, 0x00, 0x7c, 0x0e,
+  0x00, 0x06, 0x81, 0xfe, 0x45, 0x00, 0x00, 0xf4,
+  0x00, 0x00, 0xaa, 0xff, 0xff, 0x04, 0xc2, 0x92,
+  0xf2, 0x9e, 0x60, 0x0a, 0x35, 0xf0, 0x3f, 0x46,
+  0x63, 0x83, 0x3b, 0x7c, 0x96, 0xcc, 0x3f, 0x23,
+  0x5a, 0xd0, 0x42, 0x32, 0x00, 0x00, 0x05, 0x00,
+  0x00, 0x2c, 0x00, 0x00, 0xeb, 0xae, 0xe0, 0x00,
+  0x59, 0x00, 0xbe, 0x6b, 0xff, 0xe4, 0x1d, 0x01,
+  0x00, 0x00, 0x00, 0xff, 0xff, 0x01, 0xff, 0xe4
+};
+
+// Normalization as originally shipped.
+inline float normalizeAngle(float northHeading) noexcept {
+    while (northHeading < -M_PI) {
+        northHeading += 2.0f * static_cast<float>(M_PI);
+    }
+    while (northHeading > M_PI) {
+        northHeading -= 2.0f * static_cast<float>(M_PI);
+    }
+    return northHeading;
+}
+
+struct Readings {
+    double latitude;
+    double longitude;
+    float northHeading;
+};
+
+// Stream-based decoder as originally shipped.
+inline Readings decode(const std::string &data) {
+    std::stringstream buffer{data};
+    double latitude{0.0};
+    double longitude{0.0};
+    buffer.seekg(23);
+    buffer.read(reinterpret_cast<char*>(&latitude), sizeof(double));
+    buffer.read(reinterpret_cast<char*>(&longitude), sizeof(double));
+
+    buffer.seekg(52);
+    std::array<char, 4> tmp{{0, 0, 0, 0}};
+    buffer.read(tmp.data(), 3);
+    uint32_t value{0};
+    std::memcpy(&value, tmp.data(), 4);
+    value = le32toh(value);
+    const float northHeading{normalizeAngle(value * 1e-6f)};
+    return Readings{latitude / M_PI * 180.0, longitude / M_PI * 180.0, northHeading};
+}
+
+} // namespace legacy
+
+#endif
@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_NCOM
+#define OXTS_NCOM
+
+#include "cluon-complete.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ratio>
+#include <type_traits>
+
+/**
+ * Compile-time description of the NCOM packet layout.
+ *
+ * Every channel is a type carrying its offset, width, raw representation
+ * (which also determines signedness), and scale. The extractors raw<F>()
+ * and value<F>() are instantiated per field so that all offsets and
+ * scales are constants and the loads fold into straight-line code.
+ */
+namespace ncom {
+
+constexpr std::size_t PACKET_LENGTH{72};
+constexpr uint8_t SYNC{0xE7};
+
+/**
+ * @tparam RAW Type holding the raw value; integral types are read as little-endian and sign-extended if signed.
+ * @tparam OFFSET_ Offset of the first byte within the packet.
+ * @tparam WIDTH_ Number of bytes occupied within the packet.
+ * @tparam SCALE Factor to convert the raw value to SI units.
+ */
+template <typename RAW, std::size_t OFFSET_, std::size_t WIDTH_, typename SCALE = std::ratio<1> >
+struct Field {
+    static_assert(std::is_arithmetic<RAW>::value, "Raw type must be arithmetic.");
+    static_assert((0 < WIDTH_) && (WIDTH_ <= sizeof(RAW)), "Raw type must hold the field.");
+    static_assert(std::is_integral<RAW>::value || (sizeof(RAW) == WIDTH_), "Floating point fields must be complete.");
+    static_assert(OFFSET_ + WIDTH_ <= PACKET_LENGTH, "Field must be located within the packet.");
+
+    using raw_type   = RAW;
+    using value_type = typename std::conditional<std::is_same<RAW, double>::value, double, float>::type;
+
+    static constexpr std::size_t OFFSET{OFFSET_};
+    static constexpr std::size_t WIDTH{WIDTH_};
+
+    static constexpr value_type scale() noexcept {
+        return static_cast<value_type>(SCALE::num) / static_cast<value_type>(SCALE::den);
+    }
+};
+
+namespace detail {
+template <typename T, std::size_t WIDTH, bool INTEGRAL = std::is_integral<T>::value>
+struct Reader {
+    static T read(const uint8_t *p) noexcept {
+        static_assert(WIDTH <= sizeof(uint32_t), "Integral fields wider than four bytes are not supported.");
+        uint32_t value{0};
+        for (std::size_t i{0}; i < WIDTH; i++) {
+            value |= static_cast<uint32_t>(p[i]) << (8 * i);
+        }
+        if (std::is_signed<T>::value && (WIDTH < sizeof(uint32_t))) {
+            // Sign-extend from bit WIDTH * 8 - 1.
+            constexpr uint32_t SIGN{1u << (8 * WIDTH - 1)};
+            return static_cast<T>(static_cast<int32_t>(value ^ SIGN) - static_cast<int32_t>(SIGN));
+        }
+        return static_cast<T>(value);
+    }
+};
+
+template <std::size_t WIDTH>
+struct Reader<float, WIDTH, false> {
+    static float read(const uint8_t *p) noexcept {
+        uint32_t bits{0};
+        std::memcpy(&bits, p, sizeof(bits));
+        bits = le32toh(bits);
+        float value{0.0f};
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
+template <std::size_t WIDTH>
+struct Reader<double, WIDTH, false> {
+    static double read(const uint8_t *p) noexcept {
+        uint64_t bits{0};
+        std::memcpy(&bits, p, sizeof(bits));
+        bits = le64toh(bits);
+        double value{0.0};
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+} // namespace detail
+
+/**
+ * @return Raw value of FIELD from the given packet.
+ */
+template <typename FIELD>
+inline typename FIELD::raw_type raw(const uint8_t *packet) noexcept {
+    return detail::Reader<typename FIELD::raw_type, FIELD::WIDTH>::read(packet + FIELD::OFFSET);
+}
+
+/**
+ * @return Value of FIELD from the given packet, scaled to SI units.
+ */
+template <typename FIELD>
+inline typename FIELD::value_type value(const uint8_t *packet) noexcept {
+    return static_cast<typename FIELD::value_type>(raw<FIELD>(packet)) * FIELD::scale();
+}
+
+// normalizeAngle() compares against M_PI in double precision; for a float
+// x, x > M_PI holds if and only if x > PI_BELOW, the largest float below M_PI.
+constexpr float PI_BELOW{3.14159250259399414f};
+constexpr float TWO_PI{2.0f * static_cast<float>(M_PI)};
+// Number of corrections by TWO_PI needed in either direction for |angle| < 7 * M_PI.
+constexpr uint32_t NORMALIZATION_STEPS{3};
+static_assert(static_cast<double>(1u << 24) * 1e-6 < 7.0 * M_PI, "24 bit angles must be normalizable.");
+
+/**
+ * This function normalizes an angle between -M_PI .. M_PI in constant time
+ * and without data-dependent branches. For |angle| < 7 * M_PI, which covers
+ * every 24 bit angle in NCOM, the result is identical to repeatedly adding
+ * or subtracting 2 * M_PI while the angle is out of range.
+ *
+ * @param angle Angle [rad].
+ * @return Normalized angle [rad].
+ */
+inline float normalizeAngle(float angle) noexcept {
+    for (uint32_t i{0}; i < NORMALIZATION_STEPS; i++) {
+        angle += TWO_PI * static_cast<float>(angle < -PI_BELOW);
+    }
+    for (uint32_t i{0}; i < NORMALIZATION_STEPS; i++) {
+        angle -= TWO_PI * static_cast<float>(angle > PI_BELOW);
+    }
+    return angle;
+}
+
+/**
+ * Ordered list of fields; isValid() verifies at compile time that the
+ * fields do not overlap and lie within the packet.
+ */
+template <typename... FIELDS>
+struct Layout;
+
+template <>
+struct Layout<> {
+    static constexpr bool isValid(std::size_t /*begin*/ = 0) noexcept {
+        return true;
+    }
+};
+
+template <typename FIELD, typename... FIELDS>
+struct Layout<FIELD, FIELDS...> {
+    static constexpr bool isValid(std::size_t begin = 0) noexcept {
+        return (begin <= FIELD::OFFSET) && (FIELD::OFFSET + FIELD::WIDTH <= PACKET_LENGTH)
+               && Layout<FIELDS...>::isValid(FIELD::OFFSET + FIELD::WIDTH);
+    }
+};
+
+using AccelerationScale = std::ratio<1, 10000>;   // m/s^2
+using AngularRateScale  = std::ratio<1, 100000>;  // rad/s
+using VelocityScale     = std::ratio<1, 10000>;   // m/s
+using AngleScale        = std::ratio<1, 1000000>; // rad
+
+// Batch A.
+using Sync             = Field<uint8_t, 0, 1>;
+using Time             = Field<uint16_t, 1, 2>;
+using AccelerationX    = Field<int32_t, 3, 3, AccelerationScale>;
+using AccelerationY    = Field<int32_t, 6, 3, AccelerationScale>;
+using AccelerationZ    = Field<int32_t, 9, 3, AccelerationScale>;
+using AngularRateX     = Field<int32_t, 12, 3, AngularRateScale>;
+using AngularRateY     = Field<int32_t, 15, 3, AngularRateScale>;
+using AngularRateZ     = Field<int32_t, 18, 3, AngularRateScale>;
+using NavigationStatus = Field<uint8_t, 21, 1>;
+using Checksum1        = Field<uint8_t, 22, 1>;
+
+// Batch B.
+using Latitude      = Field<double, 23, 8>;
+using Longitude     = Field<double, 31, 8>;
+using Altitude      = Field<float, 39, 4>;
+using VelocityNorth = Field<int32_t, 43, 3, VelocityScale>;
+using VelocityEast  = Field<int32_t, 46, 3, VelocityScale>;
+using VelocityDown  = Field<int32_t, 49, 3, VelocityScale>;
+// Heading is signed like pitch and roll; the original decoder read it unsigned, off by 2^24 urad when negative.
+using Heading   = Field<int32_t, 52, 3, AngleScale>;
+using Pitch     = Field<int32_t, 55, 3, AngleScale>;
+using Roll      = Field<int32_t, 58, 3, AngleScale>;
+using Checksum2 = Field<uint8_t, 61, 1>;
+
+// Batch S.
+using StatusChannel = Field<uint8_t, 62, 1>;
+using Checksum3     = Field<uint8_t, 71, 1>;
+
+using PacketLayout = Layout<Sync, Time, AccelerationX, AccelerationY, AccelerationZ, AngularRateX, AngularRateY,
+                            AngularRateZ, NavigationStatus, Checksum1, Latitude, Longitude, Altitude, VelocityNorth,
+                            VelocityEast, VelocityDown, Heading, Pitch, Roll, Checksum2, StatusChannel, Checksum3>;
+static_assert(PacketLayout::isValid(), "NCOM fields must not overlap.");
+
+/**
+ * Bytes 63..70 are interpreted according to the status channel number in
+ * byte 62; the fields of the individual channels therefore overlap.
+ */
+namespace status {
+constexpr std::size_t DATA_OFFSET{StatusChannel::OFFSET + StatusChannel::WIDTH};
+constexpr std::size_t DATA_LENGTH{Checksum3::OFFSET - DATA_OFFSET};
+
+// Channel 0: Full time and number of satellites.
+constexpr uint8_t GPS_TIME_CHANNEL{0};
+// Minutes since the GPS epoch (1980-01-06 00:00:00).
+using GpsMinutes      = Field<uint32_t, 63, 4>;
+using Satellites      = Field<uint8_t, 67, 1>;
+using PositionMode    = Field<uint8_t, 68, 1>;
+using VelocityMode    = Field<uint8_t, 69, 1>;
+using OrientationMode = Field<uint8_t, 70, 1>;
+
+// Channels 3, 4, and 5: Standard deviations north/east/down of position
+// and velocity, and of heading/pitch/roll.
+constexpr uint8_t POSITION_ACCURACY_CHANNEL{3};
+constexpr uint8_t VELOCITY_ACCURACY_CHANNEL{4};
+constexpr uint8_t ORIENTATION_ACCURACY_CHANNEL{5};
+using PositionAccuracyScale    = std::ratio<1, 1000>;   // m
+using VelocityAccuracyScale    = std::ratio<1, 1000>;   // m/s
+using OrientationAccuracyScale = std::ratio<1, 100000>; // rad
+template <std::size_t AXIS, typename SCALE>
+using Accuracy    = Field<uint16_t, 63 + 2 * AXIS, 2, SCALE>;
+using AccuracyAge = Field<uint8_t, 69, 1>;
+// Accuracies of this age or older are invalid.
+constexpr uint8_t MAX_ACCURACY_AGE{150};
+} // namespace status
+
+/**
+ * Values of NavigationStatus (byte 21).
+ */
+namespace navigation {
+constexpr uint8_t INVALID{0};
+// Batch A holds raw IMU measurements; no navigation.
+constexpr uint8_t RAW_IMU{1};
+// Aligning: waiting for GNSS, then converging.
+constexpr uint8_t INITIALISING{2};
+constexpr uint8_t LOCKING{3};
+// Real-time navigation outputs are valid.
+constexpr uint8_t LOCKED{4};
+// Only the status channel is valid.
+constexpr uint8_t STATUS_ONLY{10};
+// Out-of-band packets for external triggers while initialising, locking, or locked.
+constexpr uint8_t TRIGGER_INITIALISING{20};
+constexpr uint8_t TRIGGER_LOCKING{21};
+constexpr uint8_t TRIGGER_LOCKED{22};
+} // namespace navigation
+
+// Milliseconds per GPS minute; larger values of Time are invalid.
+constexpr uint16_t MILLISECONDS_PER_MINUTE{60000};
+
+/**
+ * @return true if a packet starts at data, i.e. a sync byte followed by a valid
+ *         checksum 2 or 3, so that at least its navigation can be decoded;
+ *         PACKET_LENGTH bytes must be readable at data.
+ */
+inline bool isFramed(const uint8_t *data) noexcept {
+    if (SYNC != raw<Sync>(data)) {
+        return false;
+    }
+    uint32_t sum{0};
+    for (std::size_t i{Sync::OFFSET + Sync::WIDTH}; i < Checksum2::OFFSET; i++) {
+        sum += data[i];
+    }
+    if (static_cast<uint8_t>(sum) == raw<Checksum2>(data)) {
+        return true;
+    }
+    for (std::size_t i{Checksum2::OFFSET}; i < Checksum3::OFFSET; i++) {
+        sum += data[i];
+    }
+    return static_cast<uint8_t>(sum) == raw<Checksum3>(data);
+}
+
+} // namespace ncom
+
+#endif
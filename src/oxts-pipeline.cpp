@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "oxts-pipeline.hpp"
+
+#include <cstring>
+#include <iostream>
+
+constexpr std::chrono::milliseconds OxTSPipeline::IDLE_INTERVAL;
+
+OxTSPipeline::OxTSPipeline(spsc::Overflow overflow, Delegate delegate, Idle idle) noexcept
+    : m_ring(overflow)
+    , m_delegate(delegate)
+    , m_idle(idle) {
+    // Constructing a thread could fail.
+    try {
+        m_running.store(true);
+        m_consumerThread = std::thread(&OxTSPipeline::consume, this);
+    } catch (...) {
+        m_running.store(false);
+        std::cerr << "[OxTSPipeline] Failed to start consuming thread." << std::endl;
+    }
+}
+
+OxTSPipeline::~OxTSPipeline() noexcept {
+    stop();
+}
+
+void OxTSPipeline::stop() noexcept {
+    m_running.store(false);
+    {
+        std::lock_guard<std::mutex> lck(m_wakeupMutex);
+        m_wakeup.notify_all();
+    }
+
+    // Joining the thread could fail.
+    try {
+        if (m_consumerThread.joinable()) {
+            m_consumerThread.join();
+        }
+    } catch (...) {}
+}
+
+bool OxTSPipeline::push(uint32_t unit, const uint8_t *data, std::size_t length, const std::chrono::system_clock::time_point &tp) noexcept {
+    Packet packet{};
+    const std::size_t LENGTH{(length < packet.data.size()) ? length : packet.data.size()};
+    std::memcpy(packet.data.data(), data, LENGTH);
+    packet.length   = static_cast<uint8_t>(LENGTH);
+    packet.unit     = unit;
+    packet.received = tp;
+
+    const bool retVal{m_ring.push(packet, &m_running)};
+
+    // Pairs with the fence in consume(): Either the consumer sees the new
+    // packet before going to sleep, or this thread sees it sleeping.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (retVal && m_sleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lck(m_wakeupMutex);
+        m_wakeup.notify_one();
+    }
+    return retVal;
+}
+
+const spsc::Statistics &OxTSPipeline::statistics() const noexcept {
+    return m_ring.statistics();
+}
+
+void OxTSPipeline::consume() noexcept {
+    // Yield for a while before sleeping to catch packets arriving in bursts.
+    constexpr uint32_t SPINS{64};
+    uint32_t spins{0};
+    while (m_running.load()) {
+        const Packet *packet{m_ring.front()};
+        if (nullptr != packet) {
+            if (nullptr != m_delegate) {
+                m_delegate(packet->unit, packet->data.data(), packet->length, packet->received);
+            }
+            m_ring.pop();
+            spins = 0;
+        } else if (SPINS > ++spins) {
+            std::this_thread::yield();
+        } else {
+            std::unique_lock<std::mutex> lck(m_wakeupMutex);
+            m_sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            // The timeout guards against missing a shutdown and lets the idle delegate run.
+            const bool IS_WOKEN{m_wakeup.wait_for(lck, IDLE_INTERVAL, [this]() { return !m_ring.empty() || !m_running.load(); })};
+            m_sleeping.store(false, std::memory_order_relaxed);
+            lck.unlock();
+            if (!IS_WOKEN && (nullptr != m_idle)) {
+                m_idle();
+            }
+            spins = 0;
+        }
+    }
+}
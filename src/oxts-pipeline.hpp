@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_PIPELINE
+#define OXTS_PIPELINE
+
+#include "oxts-ncom.hpp"
+#include "oxts-spsc-ring.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * Decouples receiving from decoding and publishing: The receiving thread
+ * only copies raw packets with their receive time stamps into a lock-free
+ * ring, from which a dedicated thread hands them to the delegate. Stalls
+ * while publishing therefore do not delay draining the socket.
+ */
+class OxTSPipeline {
+   private:
+    OxTSPipeline(const OxTSPipeline &) = delete;
+    OxTSPipeline(OxTSPipeline &&)      = delete;
+    OxTSPipeline &operator=(const OxTSPipeline &) = delete;
+    OxTSPipeline &operator=(OxTSPipeline &&) = delete;
+
+   public:
+    /**
+     * Delegate to handle a queued packet; data is only valid during the call.
+     * Parameters are the unit, the packet's bytes, their length, and the receive time.
+     */
+    using Delegate
+        = std::function<void(uint32_t, const uint8_t *, std::size_t, const std::chrono::system_clock::time_point &)>;
+
+    /**
+     * Delegate called from the pipeline's thread at least every IDLE_INTERVAL while no packets are queued.
+     */
+    using Idle = std::function<void()>;
+
+    // Number of packets that can be queued (about 4 s of a unit at 250 Hz).
+    static constexpr std::size_t CAPACITY{1024};
+    // Longest time the pipeline's thread sleeps while no packets are queued.
+    static constexpr std::chrono::milliseconds IDLE_INTERVAL{10};
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param overflow Behavior when CAPACITY packets are queued.
+     * @param delegate Functional (noexcept) called from the pipeline's thread.
+     * @param idle Functional (noexcept) called from the pipeline's thread while no packets are queued.
+     */
+    OxTSPipeline(spsc::Overflow overflow, Delegate delegate, Idle idle = nullptr) noexcept;
+    ~OxTSPipeline() noexcept;
+
+    /**
+     * This method stops the pipeline's thread after the packet being handed
+     * over; queued packets are discarded. Called by the destructor.
+     */
+    void stop() noexcept;
+
+    /**
+     * This method queues a packet; it must only be called from one thread.
+     *
+     * @param unit Index of the unit that sent the packet.
+     * @return true if the packet was queued, false if it was dropped.
+     */
+    bool push(uint32_t unit, const uint8_t *data, std::size_t length, const std::chrono::system_clock::time_point &tp) noexcept;
+
+    /**
+     * @return Counters for queued and dropped packets, and the queue depth.
+     */
+    const spsc::Statistics &statistics() const noexcept;
+
+   private:
+    void consume() noexcept;
+
+   private:
+    struct Packet {
+        // Longer datagrams are truncated and rejected when decoding.
+        std::array<uint8_t, ncom::PACKET_LENGTH + 1> data;
+        uint8_t length;
+        uint32_t unit;
+        std::chrono::system_clock::time_point received;
+    };
+
+    spsc::Ring<Packet, CAPACITY> m_ring;
+    Delegate m_delegate{};
+    Idle m_idle{};
+
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_sleeping{false};
+    std::mutex m_wakeupMutex{};
+    std::condition_variable m_wakeup{};
+    std::thread m_consumerThread{};
+};
+
+#endif
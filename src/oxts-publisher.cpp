@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "oxts-publisher.hpp"
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <iostream>
+
+namespace od4 {
+
+namespace {
+constexpr uint16_t OD4_PORT{12175};
+constexpr std::size_t OD4_HEADER_SIZE{5};
+using detail::key;
+using detail::toVarInt;
+using detail::LENGTH_DELIMITED;
+using detail::VARINT;
+
+uint32_t toZigZag32(int32_t v) noexcept {
+    return static_cast<uint32_t>((v << 1) ^ (v >> 31));
+}
+
+// Encodes a nested cluon::data::TimeStamp including its key and length.
+uint8_t *putTimeStamp(uint8_t *p, uint8_t id, const cluon::data::TimeStamp &ts) noexcept {
+    std::array<uint8_t, 12> nested;
+    uint8_t *n{nested.data()};
+    *n++ = key(1, VARINT);
+    n = toVarInt(n, toZigZag32(ts.seconds()));
+    *n++ = key(2, VARINT);
+    n = toVarInt(n, toZigZag32(ts.microseconds()));
+
+    const std::size_t LENGTH{static_cast<std::size_t>(n - nested.data())};
+    *p++ = key(id, LENGTH_DELIMITED);
+    *p++ = static_cast<uint8_t>(LENGTH);
+    std::memcpy(p, nested.data(), LENGTH);
+    return p + LENGTH;
+}
+} // namespace
+
+Publisher::Publisher(uint16_t CID) noexcept {
+    prepare<opendlv::proxy::GeodeticWgs84Reading>();
+    prepare<opendlv::proxy::GeodeticHeadingReading>();
+    prepare<opendlv::proxy::AltitudeReading>();
+    prepare<opendlv::proxy::AccelerationReading>();
+    prepare<opendlv::proxy::AngularVelocityReading>();
+    prepare<opendlv::logic::sensation::Equilibrioception>();
+    prepare<opendlv::body::SensorInfo>();
+
+    for (std::size_t i{0}; i < QUEUE_CAPACITY; i++) {
+        m_iovecs[i].iov_base              = m_queue[i].data();
+        m_messages[i].msg_hdr.msg_name    = &m_sendToAddress;
+        m_messages[i].msg_hdr.msg_namelen = sizeof(m_sendToAddress);
+        m_messages[i].msg_hdr.msg_iov     = &m_iovecs[i];
+        m_messages[i].msg_hdr.msg_iovlen  = 1;
+    }
+
+    if ( (0 < CID) && (CID < 255) ) {
+        const std::string ADDRESS{"225.0.0." + std::to_string(CID)};
+        std::memset(&m_sendToAddress, 0, sizeof(m_sendToAddress));
+        m_sendToAddress.sin_addr.s_addr = ::inet_addr(ADDRESS.c_str());
+        m_sendToAddress.sin_family      = AF_INET;
+        m_sendToAddress.sin_port        = htons(OD4_PORT);
+
+        m_socket = ::socket(PF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+        if (m_socket < 0) {
+            std::cerr << "[od4::Publisher] Failed to create socket: " << ::strerror(errno) << std::endl;
+        }
+    }
+}
+
+Publisher::~Publisher() noexcept {
+    if (!(m_socket < 0)) {
+        ::shutdown(m_socket, SHUT_RDWR); // Disallow further read/write operations.
+        ::close(m_socket);
+    }
+    m_socket = -1;
+}
+
+void Publisher::prepare(Frame &frame, int32_t dataType, std::size_t payloadLength) noexcept {
+    uint8_t *p{frame.buffer.data() + OD4_HEADER_SIZE};
+    *p++ = key(1, VARINT);
+    p = toVarInt(p, toZigZag32(dataType));
+    *p++ = key(2, LENGTH_DELIMITED);
+    p = toVarInt(p, payloadLength);
+    frame.payload = static_cast<std::size_t>(p - frame.buffer.data());
+    frame.suffix  = frame.payload + payloadLength;
+
+    frame.buffer[0] = 0x0D;
+    frame.buffer[1] = 0xA4;
+}
+
+std::pair<const uint8_t *, std::size_t> Publisher::finish(Frame &frame,
+                                                          const cluon::data::TimeStamp &sampleTimeStamp,
+                                                          const cluon::data::TimeStamp &sent,
+                                                          uint32_t senderStamp) noexcept {
+    uint8_t *p{frame.buffer.data() + frame.suffix};
+    p = putTimeStamp(p, 3, sent);
+    p = putTimeStamp(p, 4, cluon::data::TimeStamp{});
+    p = putTimeStamp(p, 5, (0 == (sampleTimeStamp.seconds() + sampleTimeStamp.microseconds())) ? sent : sampleTimeStamp);
+    *p++ = key(6, VARINT);
+    p = toVarInt(p, senderStamp);
+
+    // Three bytes little endian length of the Envelope following the header.
+    const std::size_t LENGTH{static_cast<std::size_t>(p - frame.buffer.data())};
+    const std::size_t ENVELOPE{LENGTH - OD4_HEADER_SIZE};
+    frame.buffer[2] = static_cast<uint8_t>(ENVELOPE & 0xFF);
+    frame.buffer[3] = static_cast<uint8_t>((ENVELOPE >> 8) & 0xFF);
+    frame.buffer[4] = static_cast<uint8_t>((ENVELOPE >> 16) & 0xFF);
+    return {frame.buffer.data(), LENGTH};
+}
+
+void Publisher::transmit(const uint8_t *data, std::size_t length) noexcept {
+    if (!(m_socket < 0)) {
+        ::sendto(m_socket, data, length, 0, reinterpret_cast<const struct sockaddr *>(&m_sendToAddress), sizeof(m_sendToAddress));
+    }
+}
+
+void Publisher::flush() noexcept {
+    std::size_t sent{0};
+    while (!(m_socket < 0) && (sent < m_queued)) {
+        const int RESULT{::sendmmsg(m_socket, m_messages.data() + sent, static_cast<uint32_t>(m_queued - sent), 0)};
+        if ( (0 > RESULT) && (EINTR == errno) ) {
+            continue;
+        }
+        if (0 >= RESULT) {
+            break; // Lost like a failed sendto.
+        }
+        sent += static_cast<std::size_t>(RESULT);
+    }
+    m_queued = 0;
+}
+
+} // namespace od4
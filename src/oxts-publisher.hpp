@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_PUBLISHER
+#define OXTS_PUBLISHER
+
+#include "cluon-complete.hpp"
+#include "opendlv-standard-message-set.hpp"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace od4 {
+
+namespace detail {
+// Proto wire types.
+constexpr uint8_t VARINT{0};
+constexpr uint8_t EIGHT_BYTES{1};
+constexpr uint8_t LENGTH_DELIMITED{2};
+constexpr uint8_t FOUR_BYTES{5};
+
+constexpr uint8_t key(uint8_t id, uint8_t type) noexcept {
+    return static_cast<uint8_t>((id << 3) | type);
+}
+
+inline uint8_t *toVarInt(uint8_t *p, uint64_t v) noexcept {
+    while (0x7f < v) {
+        *p++ = static_cast<uint8_t>((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    *p++ = static_cast<uint8_t>(v);
+    return p;
+}
+
+inline uint8_t *put(uint8_t *p, uint8_t id, double v) noexcept {
+    uint64_t bits{0};
+    std::memcpy(&bits, &v, sizeof(bits));
+    bits = htole64(bits);
+    *p++ = key(id, EIGHT_BYTES);
+    std::memcpy(p, &bits, sizeof(bits));
+    return p + sizeof(bits);
+}
+
+inline uint8_t *put(uint8_t *p, uint8_t id, float v) noexcept {
+    uint32_t bits{0};
+    std::memcpy(&bits, &v, sizeof(bits));
+    bits = htole32(bits);
+    *p++ = key(id, FOUR_BYTES);
+    std::memcpy(p, &bits, sizeof(bits));
+    return p + sizeof(bits);
+}
+
+// Unsigned integral fields.
+inline uint8_t *putVarInt(uint8_t *p, uint8_t id, uint64_t v) noexcept {
+    *p++ = key(id, VARINT);
+    return toVarInt(p, v);
+}
+
+// Strings of at most 127 bytes.
+inline uint8_t *putString(uint8_t *p, uint8_t id, const std::string &v) noexcept {
+    *p++ = key(id, LENGTH_DELIMITED);
+    *p++ = static_cast<uint8_t>(v.size());
+    std::memcpy(p, v.data(), v.size());
+    return p + v.size();
+}
+} // namespace detail
+
+/**
+ * Proto encoding of messages whose encoding is short and bounded. LENGTH is
+ * the largest encoded length, which is exact for messages consisting of
+ * floating point fields only. encode() returns the end of the encoding.
+ * INDEX selects the frame that is kept per message type by the Publisher.
+ */
+template <typename T>
+struct Payload;
+
+template <>
+struct Payload<opendlv::proxy::GeodeticWgs84Reading> {
+    static constexpr std::size_t INDEX{0};
+    static constexpr std::size_t LENGTH{2 * 9};
+    static uint8_t *encode(const opendlv::proxy::GeodeticWgs84Reading &m, uint8_t *p) noexcept {
+        return detail::put(detail::put(p, 1, m.latitude()), 3, m.longitude());
+    }
+};
+
+template <>
+struct Payload<opendlv::proxy::GeodeticHeadingReading> {
+    static constexpr std::size_t INDEX{1};
+    static constexpr std::size_t LENGTH{5};
+    static uint8_t *encode(const opendlv::proxy::GeodeticHeadingReading &m, uint8_t *p) noexcept {
+        return detail::put(p, 1, m.northHeading());
+    }
+};
+
+template <>
+struct Payload<opendlv::proxy::AltitudeReading> {
+    static constexpr std::size_t INDEX{2};
+    static constexpr std::size_t LENGTH{5};
+    static uint8_t *encode(const opendlv::proxy::AltitudeReading &m, uint8_t *p) noexcept {
+        return detail::put(p, 1, m.altitude());
+    }
+};
+
+template <>
+struct Payload<opendlv::proxy::AccelerationReading> {
+    static constexpr std::size_t INDEX{3};
+    static constexpr std::size_t LENGTH{3 * 5};
+    static uint8_t *encode(const opendlv::proxy::AccelerationReading &m, uint8_t *p) noexcept {
+        return detail::put(detail::put(detail::put(p, 1, m.accelerationX()), 2, m.accelerationY()), 3, m.accelerationZ());
+    }
+};
+
+template <>
+struct Payload<opendlv::proxy::AngularVelocityReading> {
+    static constexpr std::size_t INDEX{4};
+    static constexpr std::size_t LENGTH{3 * 5};
+    static uint8_t *encode(const opendlv::proxy::AngularVelocityReading &m, uint8_t *p) noexcept {
+        return detail::put(detail::put(detail::put(p, 1, m.angularVelocityX()), 2, m.angularVelocityY()), 3, m.angularVelocityZ());
+    }
+};
+
+template <>
+struct Payload<opendlv::logic::sensation::Equilibrioception> {
+    static constexpr std::size_t INDEX{5};
+    static constexpr std::size_t LENGTH{6 * 5};
+    static uint8_t *encode(const opendlv::logic::sensation::Equilibrioception &m, uint8_t *p) noexcept {
+        p = detail::put(detail::put(detail::put(p, 1, m.vx()), 2, m.vy()), 3, m.vz());
+        return detail::put(detail::put(detail::put(p, 4, m.rollRate()), 5, m.pitchRate()), 6, m.yawRate());
+    }
+};
+
+template <>
+struct Payload<opendlv::body::SensorInfo> {
+    // Longer descriptions are truncated.
+    static constexpr std::size_t DESCRIPTION_CAPACITY{32};
+    static constexpr std::size_t INDEX{6};
+    static constexpr std::size_t LENGTH{2 + DESCRIPTION_CAPACITY + 3 * 5 + 6 + 5 + 4};
+    static uint8_t *encode(const opendlv::body::SensorInfo &m, uint8_t *p) noexcept {
+        // Descriptions within the small string buffer are returned without allocating.
+        const std::string DESCRIPTION{m.description()};
+        p = detail::putString(p, 1, (DESCRIPTION.size() > DESCRIPTION_CAPACITY) ? DESCRIPTION.substr(0, DESCRIPTION_CAPACITY) : DESCRIPTION);
+        p = detail::put(detail::put(detail::put(p, 2, m.x()), 3, m.y()), 4, m.z());
+        p = detail::put(detail::putVarInt(p, 5, m.signalId()), 6, m.accuracyStd());
+        return detail::putVarInt(p, 7, m.minFrequency());
+    }
+};
+
+/**
+ * Allocation-free replacement for cluon::OD4Session::send() for the message
+ * types with a Payload specialization. Per message type, the OD4 header and
+ * the leading Envelope fields are encoded once into a reusable frame; sending
+ * a message only overwrites its payload, appends the time stamps, and patches
+ * the length. The resulting bytes are identical to OD4Session's encoding.
+ *
+ * Messages can also be queued and sent together by flush() with a single
+ * sendmmsg, which separates encoding from handing the frames to the kernel.
+ *
+ * Not thread-safe: Use one Publisher per sending thread.
+ */
+class Publisher {
+   private:
+    Publisher(const Publisher &) = delete;
+    Publisher(Publisher &&)      = delete;
+    Publisher &operator=(const Publisher &) = delete;
+    Publisher &operator=(Publisher &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param CID OpenDaVINCI v4 session identifier [1 .. 254]
+     */
+    explicit Publisher(uint16_t CID) noexcept;
+    ~Publisher() noexcept;
+
+    /**
+     * This method sends a message to the OpenDaVINCI v4 session.
+     *
+     * @param message Message to be sent.
+     * @param sampleTimeStamp Time point when this sample was captured (default = sent time point).
+     * @param senderStamp Optional sender stamp (default = 0).
+     */
+    template <typename T>
+    void send(const T &message,
+              const cluon::data::TimeStamp &sampleTimeStamp = cluon::data::TimeStamp(),
+              uint32_t senderStamp                          = 0) noexcept {
+        const auto FRAME = serialize(message, sampleTimeStamp, cluon::time::now(), senderStamp);
+        transmit(FRAME.first, FRAME.second);
+    }
+
+    /**
+     * This method encodes a message and keeps it until the next flush(); the
+     * queue is flushed first if it is full.
+     *
+     * @param message Message to be sent.
+     * @param sampleTimeStamp Time point when this sample was captured (default = sent time point).
+     * @param senderStamp Optional sender stamp (default = 0).
+     */
+    template <typename T>
+    void queue(const T &message,
+               const cluon::data::TimeStamp &sampleTimeStamp = cluon::data::TimeStamp(),
+               uint32_t senderStamp                          = 0) noexcept {
+        if (QUEUE_CAPACITY == m_queued) {
+            flush();
+        }
+        const auto FRAME = serialize(message, sampleTimeStamp, cluon::time::now(), senderStamp);
+        std::memcpy(m_queue[m_queued].data(), FRAME.first, FRAME.second);
+        m_messages[m_queued].msg_hdr.msg_iov->iov_len = FRAME.second;
+        m_queued++;
+    }
+
+    /**
+     * This method sends all queued messages with one system call.
+     */
+    void flush() noexcept;
+
+    /**
+     * This method encodes a message into the reusable frame of its type.
+     *
+     * @return Pointer to and length of the encoded OD4 container; valid until the next call for this type.
+     */
+    template <typename T>
+    std::pair<const uint8_t *, std::size_t> serialize(const T &message,
+                                                      const cluon::data::TimeStamp &sampleTimeStamp,
+                                                      const cluon::data::TimeStamp &sent,
+                                                      uint32_t senderStamp) noexcept {
+        Frame &frame = m_frames[Payload<T>::INDEX];
+        uint8_t *payload{frame.buffer.data() + frame.payload};
+        const std::size_t LENGTH{static_cast<std::size_t>(Payload<T>::encode(message, payload) - payload)};
+        // The payload's length is the single byte preceding it.
+        frame.buffer[frame.payload - 1] = static_cast<uint8_t>(LENGTH);
+        frame.suffix                    = frame.payload + LENGTH;
+        return finish(frame, sampleTimeStamp, sent, senderStamp);
+    }
+
+   private:
+    // OD4 header, Envelope fields 1..6 with at most five bytes per varint, and the payload.
+    static constexpr std::size_t CAPACITY{128};
+    // CAPACITY less the OD4 header, the Envelope fields, and the payload's key and length.
+    static constexpr std::size_t MAX_PAYLOAD_LENGTH{CAPACITY - 5 - 6 - 2 - 3 * 14 - 6};
+    // Enough for all readings and accuracies of one packet.
+    static constexpr std::size_t QUEUE_CAPACITY{16};
+
+    struct Frame {
+        std::array<uint8_t, CAPACITY> buffer{};
+        // Offset of the payload within buffer.
+        std::size_t payload{0};
+        // Offset of the first byte after the payload.
+        std::size_t suffix{0};
+    };
+
+    template <typename T>
+    void prepare() noexcept {
+        static_assert(Payload<T>::LENGTH <= MAX_PAYLOAD_LENGTH, "Payload must fit into a frame.");
+        prepare(m_frames[Payload<T>::INDEX], T::ID(), Payload<T>::LENGTH);
+    }
+    static void prepare(Frame &frame, int32_t dataType, std::size_t payloadLength) noexcept;
+    static std::pair<const uint8_t *, std::size_t> finish(Frame &frame,
+                                                          const cluon::data::TimeStamp &sampleTimeStamp,
+                                                          const cluon::data::TimeStamp &sent,
+                                                          uint32_t senderStamp) noexcept;
+    void transmit(const uint8_t *data, std::size_t length) noexcept;
+
+   private:
+    int32_t m_socket{-1};
+    struct sockaddr_in m_sendToAddress {};
+    std::array<Frame, 7> m_frames{};
+
+    // Copies of the queued frames and their headers for sendmmsg.
+    std::array<std::array<uint8_t, CAPACITY>, QUEUE_CAPACITY> m_queue{};
+    std::array<struct iovec, QUEUE_CAPACITY> m_iovecs{};
+    std::array<struct mmsghdr, QUEUE_CAPACITY> m_messages{};
+    std::size_t m_queued{0};
+};
+
+} // namespace od4
+
+#endif
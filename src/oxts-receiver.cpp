@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "oxts-receiver.hpp"
+
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace {
+// Identifies the shutdown eventfd among the units' sockets in epoll events.
+constexpr uint32_t SHUTDOWN{UINT32_MAX};
+} // namespace
+
+OxTSReceiver::OxTSReceiver(const std::string &receiveFromAddress, uint16_t receiveFromPort, Delegate delegate) noexcept
+    : OxTSReceiver(std::vector<Endpoint>{Endpoint{receiveFromAddress, receiveFromPort}},
+                   [delegate](uint32_t, const uint8_t *data, std::size_t length, const std::chrono::system_clock::time_point &tp) {
+                       if (nullptr != delegate) {
+                           delegate(data, length, tp);
+                       }
+                   }) {}
+
+OxTSReceiver::OxTSReceiver(const std::vector<Endpoint> &endpoints, UnitDelegate delegate) noexcept
+    : m_kernelDrops(endpoints.size())
+    , m_delegate(delegate) {
+    bool isValid{!endpoints.empty()};
+    try {
+        m_sockets.resize(endpoints.size());
+    } catch (...) {
+        isValid = false;
+    }
+    for (std::size_t i{0}; isValid && (i < endpoints.size()); i++) {
+        isValid = openSocket(endpoints[i], m_sockets[i]);
+    }
+
+    if (isValid) {
+        // Wait for either incoming datagrams on any socket or the shutdown signal.
+        m_shutdown = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        m_epoll    = ::epoll_create1(EPOLL_CLOEXEC);
+        isValid    = !(0 > m_shutdown) && !(0 > m_epoll);
+
+        struct epoll_event shutdownEvent {};
+        shutdownEvent.events   = EPOLLIN;
+        shutdownEvent.data.u32 = SHUTDOWN;
+        isValid = isValid && !(0 > ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_shutdown, &shutdownEvent));
+        for (uint32_t unit{0}; isValid && (unit < m_sockets.size()); unit++) {
+            struct epoll_event socketEvent {};
+            socketEvent.events   = EPOLLIN;
+            socketEvent.data.u32 = unit;
+            isValid = !(0 > ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_sockets[unit].fd, &socketEvent));
+        }
+        if (!isValid) {
+            closeSockets(errno);
+        }
+    } else {
+        closeSockets(0);
+    }
+
+    if (isValid) {
+        // Wire the ring of slots to the message headers once.
+        for (std::size_t i{0}; i < SLOTS; i++) {
+            m_iovecs[i].iov_base = m_slots[i].data();
+            m_iovecs[i].iov_len  = m_slots[i].size();
+            std::memset(&m_messages[i], 0, sizeof(m_messages[i]));
+            m_messages[i].msg_hdr.msg_iov    = &m_iovecs[i];
+            m_messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        // Constructing a thread could fail.
+        try {
+            m_readFromSocketThreadRunning.store(true);
+            m_readFromSocketThread = std::thread(&OxTSReceiver::readFromSocket, this);
+        } catch (...) {
+            m_readFromSocketThreadRunning.store(false);
+            closeSockets(ECHILD);
+        }
+    }
+}
+
+OxTSReceiver::~OxTSReceiver() noexcept {
+    m_readFromSocketThreadRunning.store(false);
+    if (!(m_shutdown < 0)) {
+        const uint64_t WAKEUP{1};
+        if (sizeof(WAKEUP) != ::write(m_shutdown, &WAKEUP, sizeof(WAKEUP))) {
+            std::cerr << "[OxTSReceiver] Failed to signal shutdown: " << ::strerror(errno) << std::endl;
+        }
+    }
+
+    // Joining the thread could fail.
+    try {
+        if (m_readFromSocketThread.joinable()) {
+            m_readFromSocketThread.join();
+        }
+    } catch (...) {}
+
+    closeSockets(0);
+}
+
+bool OxTSReceiver::openSocket(const Endpoint &endpoint, Socket &socket) noexcept {
+    struct in_addr address {};
+    if ( (0 == endpoint.port) || (1 != ::inet_pton(AF_INET, endpoint.address.c_str(), &address)) ) {
+        std::cerr << "[OxTSReceiver] Invalid endpoint " << endpoint.address << ":" << endpoint.port << std::endl;
+        return false;
+    }
+    socket.isMulticast = IN_MULTICAST(ntohl(address.s_addr));
+
+    struct sockaddr_in receiveFromAddress {};
+    receiveFromAddress.sin_addr   = address;
+    receiveFromAddress.sin_family = AF_INET;
+    receiveFromAddress.sin_port   = htons(endpoint.port);
+
+    // The socket is drained without blocking after epoll reported data.
+    socket.fd = ::socket(PF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+    bool retVal{!(socket.fd < 0)};
+
+    // Allow reusing of ports by multiple calls with same address/port.
+    int32_t YES{1};
+    retVal = retVal && !(0 > ::setsockopt(socket.fd, SOL_SOCKET, SO_REUSEADDR, &YES, sizeof(YES)));
+    // Request the kernel receive time stamp per datagram.
+    retVal = retVal && !(0 > ::setsockopt(socket.fd, SOL_SOCKET, SO_TIMESTAMPNS, &YES, sizeof(YES)));
+    // Request the number of datagrams dropped for a full receive buffer.
+    retVal = retVal && !(0 > ::setsockopt(socket.fd, SOL_SOCKET, SO_RXQ_OVFL, &YES, sizeof(YES)));
+    retVal = retVal && !(0 > ::bind(socket.fd, reinterpret_cast<struct sockaddr *>(&receiveFromAddress), sizeof(receiveFromAddress)));
+    if (retVal && socket.isMulticast) {
+        // Join the multicast group.
+        socket.mreq.imr_multiaddr        = address;
+        socket.mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+        retVal = !(0 > ::setsockopt(socket.fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &socket.mreq, sizeof(socket.mreq)));
+        // Do not drop a membership that was never added.
+        socket.isMulticast = retVal;
+    }
+    if (!retVal) {
+        std::cerr << "[OxTSReceiver] Failed to perform socket operation for " << endpoint.address << ":" << endpoint.port << ": "
+                  << ::strerror(errno) << " (" << errno << ")" << std::endl;
+    }
+    return retVal;
+}
+
+void OxTSReceiver::closeSockets(int errorCode) noexcept {
+    if (0 != errorCode) {
+        std::cerr << "[OxTSReceiver] Failed to perform socket operation: " << ::strerror(errorCode) << " (" << errorCode << ")" << std::endl;
+    }
+
+    for (auto &socket : m_sockets) {
+        if (!(socket.fd < 0)) {
+            if (socket.isMulticast) {
+                ::setsockopt(socket.fd, IPPROTO_IP, IP_DROP_MEMBERSHIP, &socket.mreq, sizeof(socket.mreq));
+            }
+            ::shutdown(socket.fd, SHUT_RDWR); // Disallow further read/write operations.
+            ::close(socket.fd);
+        }
+        socket.fd = -1;
+    }
+
+    if (!(m_epoll < 0)) {
+        ::close(m_epoll);
+    }
+    m_epoll = -1;
+    if (!(m_shutdown < 0)) {
+        ::close(m_shutdown);
+    }
+    m_shutdown = -1;
+}
+
+bool OxTSReceiver::isRunning() const noexcept {
+    return m_readFromSocketThreadRunning.load();
+}
+
+uint64_t OxTSReceiver::kernelDrops(uint32_t unit) const noexcept {
+    return (unit < m_kernelDrops.size()) ? m_kernelDrops[unit].load(std::memory_order_relaxed) : 0;
+}
+
+void OxTSReceiver::readFromSocket() noexcept {
+    while (m_readFromSocketThreadRunning.load()) {
+        // Block until datagrams arrive or the destructor signals shutdown.
+        constexpr int32_t MAX_EVENTS{8};
+        std::array<struct epoll_event, MAX_EVENTS> events{};
+        const int32_t ready{::epoll_wait(m_epoll, events.data(), MAX_EVENTS, -1)};
+        for (int32_t i{0}; i < ready; i++) {
+            const uint32_t UNIT{events[static_cast<std::size_t>(i)].data.u32};
+            if (SHUTDOWN != UNIT) {
+                receiveAll(UNIT);
+            }
+        }
+    }
+}
+
+void OxTSReceiver::receiveAll(uint32_t unit) noexcept {
+    int32_t received{0};
+    do {
+        // The control buffers are consumed by every call.
+        for (std::size_t i{0}; i < SLOTS; i++) {
+            m_messages[i].msg_hdr.msg_control    = m_controls[i].data();
+            m_messages[i].msg_hdr.msg_controllen = m_controls[i].size();
+            m_messages[i].msg_hdr.msg_flags      = 0;
+        }
+
+        // Take all datagrams that are already queued, SLOTS at a time.
+        received = ::recvmmsg(m_sockets[unit].fd, m_messages.data(), SLOTS, MSG_DONTWAIT, nullptr);
+        if (nullptr == m_delegate) {
+            continue;
+        }
+
+        for (int32_t i{0}; i < received; i++) {
+            struct msghdr &header = m_messages[static_cast<std::size_t>(i)].msg_hdr;
+
+            std::chrono::system_clock::time_point timestamp{};
+            bool hasTimestamp{false};
+            for (struct cmsghdr *c = CMSG_FIRSTHDR(&header); nullptr != c; c = CMSG_NXTHDR(&header, c)) {
+                if ( (SOL_SOCKET == c->cmsg_level) && (SCM_TIMESTAMPNS == c->cmsg_type) ) {
+                    struct timespec ts {};
+                    std::memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+                    timestamp = std::chrono::system_clock::time_point{std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                        std::chrono::seconds{ts.tv_sec} + std::chrono::nanoseconds{ts.tv_nsec})};
+                    hasTimestamp = true;
+                } else if ( (SOL_SOCKET == c->cmsg_level) && (SO_RXQ_OVFL == c->cmsg_type) ) {
+                    // The kernel's counter of the socket wraps around at 2^32.
+                    uint32_t drops{0};
+                    std::memcpy(&drops, CMSG_DATA(c), sizeof(drops));
+                    m_kernelDrops[unit].store(drops, std::memory_order_relaxed);
+                }
+            }
+            if (!hasTimestamp) {
+                timestamp = std::chrono::system_clock::now();
+            }
+
+            m_delegate(unit, m_slots[static_cast<std::size_t>(i)].data(), m_messages[static_cast<std::size_t>(i)].msg_len, timestamp);
+        }
+    } while (static_cast<int32_t>(SLOTS) == received);
+}
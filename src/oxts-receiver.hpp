@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_RECEIVER
+#define OXTS_RECEIVER
+
+#include "oxts-ncom.hpp"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * UDP receiver specialized for NCOM datagrams: Many datagrams are read per
+ * system call with recvmmsg into a preallocated ring of packet-sized slots
+ * and handed to the delegate in place, i.e., without constructing strings.
+ *
+ * The receiving thread blocks in epoll_wait until datagrams arrive and is
+ * woken up through an eventfd for shutdown; there is no periodic polling.
+ * Several units sending to different ports are served by the same thread.
+ */
+class OxTSReceiver {
+   private:
+    OxTSReceiver(const OxTSReceiver &) = delete;
+    OxTSReceiver(OxTSReceiver &&)      = delete;
+    OxTSReceiver &operator=(const OxTSReceiver &) = delete;
+    OxTSReceiver &operator=(OxTSReceiver &&) = delete;
+
+   public:
+    /**
+     * Delegate to handle a received datagram; data is only valid during the call.
+     * Parameters are the received bytes, their length, and the kernel receive time.
+     */
+    using Delegate = std::function<void(const uint8_t *, std::size_t, const std::chrono::system_clock::time_point &)>;
+
+    /**
+     * Delegate to handle a datagram received from one of several units; the
+     * first parameter is the index of the unit's Endpoint.
+     */
+    using UnitDelegate
+        = std::function<void(uint32_t, const uint8_t *, std::size_t, const std::chrono::system_clock::time_point &)>;
+
+    /**
+     * Numerical IPv4 address and port that a unit sends to.
+     */
+    struct Endpoint {
+        std::string address;
+        uint16_t port;
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param receiveFromAddress Numerical IPv4 address to receive UDP packets from.
+     * @param receiveFromPort Port to receive UDP packets from.
+     * @param delegate Functional (noexcept) to handle received datagrams.
+     */
+    OxTSReceiver(const std::string &receiveFromAddress, uint16_t receiveFromPort, Delegate delegate) noexcept;
+
+    /**
+     * Constructor to receive from several units with one thread.
+     *
+     * @param endpoints Addresses and ports to receive UDP packets from.
+     * @param delegate Functional (noexcept) to handle received datagrams.
+     */
+    OxTSReceiver(const std::vector<Endpoint> &endpoints, UnitDelegate delegate) noexcept;
+    ~OxTSReceiver() noexcept;
+
+    /**
+     * @return true if the OxTSReceiver could successfully be created for all endpoints and is able to receive data.
+     */
+    bool isRunning() const noexcept;
+
+    /**
+     * @param unit Index of the unit's Endpoint.
+     * @return Datagrams the kernel dropped for the unit's socket as its receive buffer was full.
+     */
+    uint64_t kernelDrops(uint32_t unit) const noexcept;
+
+   private:
+    struct Socket {
+        int32_t fd{-1};
+        struct ip_mreq mreq {};
+        bool isMulticast{false};
+    };
+
+    static bool openSocket(const Endpoint &endpoint, Socket &socket) noexcept;
+    void closeSockets(int errorCode) noexcept;
+    void readFromSocket() noexcept;
+    void receiveAll(uint32_t unit) noexcept;
+
+   private:
+    // Number of datagrams read per system call.
+    static constexpr std::size_t SLOTS{64};
+    // Longer datagrams are truncated to one byte more than an NCOM packet
+    // so that they are still recognized as having an invalid length.
+    static constexpr std::size_t SLOT_LENGTH{ncom::PACKET_LENGTH + 1};
+    static constexpr std::size_t CONTROL_LENGTH{CMSG_SPACE(sizeof(struct timespec)) + CMSG_SPACE(sizeof(uint32_t))};
+
+    std::vector<Socket> m_sockets{};
+    // Latest SO_RXQ_OVFL counter per unit.
+    std::vector<std::atomic<uint64_t>> m_kernelDrops;
+    int32_t m_epoll{-1};
+    int32_t m_shutdown{-1};
+
+    std::array<std::array<uint8_t, SLOT_LENGTH>, SLOTS> m_slots{};
+    alignas(struct cmsghdr) std::array<std::array<uint8_t, CONTROL_LENGTH>, SLOTS> m_controls{};
+    std::array<struct iovec, SLOTS> m_iovecs{};
+    std::array<struct mmsghdr, SLOTS> m_messages{};
+
+    std::atomic<bool> m_readFromSocketThreadRunning{false};
+    std::thread m_readFromSocketThread{};
+    UnitDelegate m_delegate{};
+};
+
+#endif
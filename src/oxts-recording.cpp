@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "oxts-recording.hpp"
+#include "oxts-ncom.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+OxTSRecording::OxTSRecording(const std::string &path) noexcept {
+    const int FD{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (FD < 0) {
+        std::cerr << "[OxTSRecording] Failed to open " << path << ": " << ::strerror(errno) << std::endl;
+        return;
+    }
+
+    struct stat info {};
+    if (0 != ::fstat(FD, &info)) {
+        std::cerr << "[OxTSRecording] Failed to stat " << path << ": " << ::strerror(errno) << std::endl;
+    } else if (0 == info.st_size) {
+        // Nothing to map.
+        m_isOpen = true;
+    } else {
+        void *data = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, FD, 0);
+        if (MAP_FAILED == data) {
+            std::cerr << "[OxTSRecording] Failed to map " << path << ": " << ::strerror(errno) << std::endl;
+        } else {
+            // The file is read once from front to back.
+            ::posix_madvise(data, static_cast<std::size_t>(info.st_size), POSIX_MADV_SEQUENTIAL);
+            m_data   = static_cast<const uint8_t *>(data);
+            m_size   = static_cast<std::size_t>(info.st_size);
+            m_isOpen = true;
+        }
+    }
+    // The mapping stays valid after closing.
+    ::close(FD);
+}
+
+OxTSRecording::~OxTSRecording() noexcept {
+    if (nullptr != m_data) {
+        ::munmap(const_cast<uint8_t *>(m_data), m_size);
+    }
+}
+
+bool OxTSRecording::isOpen() const noexcept {
+    return m_isOpen;
+}
+
+const uint8_t *OxTSRecording::begin() const noexcept {
+    return m_data;
+}
+
+const uint8_t *OxTSRecording::end() const noexcept {
+    return m_data + m_size;
+}
+
+std::size_t OxTSRecording::size() const noexcept {
+    return m_size;
+}
+
+const uint8_t *OxTSRecording::findPacket(const uint8_t *begin, const uint8_t *end) noexcept {
+    while (static_cast<std::size_t>(end - begin) >= ncom::PACKET_LENGTH) {
+        begin = static_cast<const uint8_t *>(std::memchr(begin, ncom::SYNC, static_cast<std::size_t>(end - begin)));
+        if ( (nullptr == begin) || (static_cast<std::size_t>(end - begin) < ncom::PACKET_LENGTH) ) {
+            break;
+        }
+        if (ncom::isFramed(begin)) {
+            return begin;
+        }
+        begin++;
+    }
+    return end;
+}
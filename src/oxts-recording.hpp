@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_RECORDING
+#define OXTS_RECORDING
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Read-only memory mapping of a raw NCOM recording, i.e. the concatenated
+ * packets as sent by the unit, possibly with garbage in between.
+ */
+class OxTSRecording {
+   private:
+    OxTSRecording(const OxTSRecording &) = delete;
+    OxTSRecording(OxTSRecording &&)      = delete;
+    OxTSRecording &operator=(const OxTSRecording &) = delete;
+    OxTSRecording &operator=(OxTSRecording &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param path File to be mapped.
+     */
+    explicit OxTSRecording(const std::string &path) noexcept;
+    ~OxTSRecording() noexcept;
+
+    /**
+     * @return true if the file could be mapped.
+     */
+    bool isOpen() const noexcept;
+
+    const uint8_t *begin() const noexcept;
+    const uint8_t *end() const noexcept;
+    std::size_t size() const noexcept;
+
+    /**
+     * This function searches the next packet: A sync byte followed by a
+     * complete packet whose checksum 2 or 3 is valid, so that its position
+     * can be decoded. Sync bytes within the payload are skipped that way.
+     *
+     * @param begin First byte to search from.
+     * @param end First byte after the data.
+     * @return Pointer to the next packet or end if there is none.
+     */
+    static const uint8_t *findPacket(const uint8_t *begin, const uint8_t *end) noexcept;
+
+   private:
+    bool m_isOpen{false};
+    const uint8_t *m_data{nullptr};
+    std::size_t m_size{0};
+};
+
+#endif
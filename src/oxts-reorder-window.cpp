@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "oxts-counters.hpp"
+#include "oxts-reorder-window.hpp"
+#include "oxts-ncom.hpp"
+
+#include <algorithm>
+#include <utility>
+
+using counters::increment;
+
+OxTSReorderWindow::OxTSReorderWindow(std::size_t depth, std::chrono::milliseconds period, Delegate delegate) noexcept
+    : m_period(static_cast<int32_t>(std::max<std::chrono::milliseconds::rep>(1, period.count())))
+    , m_timeout(std::chrono::milliseconds{m_period} * static_cast<int64_t>(depth))
+    , m_delegate(std::move(delegate))
+    , m_slots(depth) {}
+
+const OxTSReorderWindow::Statistics &OxTSReorderWindow::statistics() const noexcept {
+    return m_statistics;
+}
+
+void OxTSReorderWindow::push(const OxTSDecoder::Readings &readings, const std::chrono::system_clock::time_point &tp) noexcept {
+    if (m_slots.empty() || (ncom::MILLISECONDS_PER_MINUTE <= readings.time)) {
+        release(readings, tp, false);
+        return;
+    }
+    m_pushes++;
+
+    // Periods since the released time, taking the shorter way around the minute.
+    constexpr int32_t MINUTE{static_cast<int32_t>(ncom::MILLISECONDS_PER_MINUTE)};
+    int32_t delta{(static_cast<int32_t>(readings.time) - static_cast<int32_t>(m_released) + MINUTE) % MINUTE};
+    delta = (delta >= MINUTE / 2) ? delta - MINUTE : delta;
+    const int32_t PERIODS{(delta + ((0 > delta) ? -m_period : m_period) / 2) / m_period};
+    const int32_t DEPTH{static_cast<int32_t>(m_slots.size())};
+
+    if (!m_hasReleased || (-static_cast<int32_t>(OxTSDecoder::SEQUENCE_HISTORY) >= PERIODS)) {
+        // The first packet or the unit's time jumped back: start anew.
+        flush();
+        m_hasReleased = true;
+        m_released    = readings.time;
+        release(readings, tp, false);
+    } else if (0 >= PERIODS) {
+        increment(m_statistics.late);
+    } else {
+        // Give up on the missing packets that fell out of the window.
+        for (int32_t i{PERIODS - DEPTH}; 0 < i; i--) {
+            advance();
+        }
+        Slot &slot = m_slots[(m_next + static_cast<std::size_t>(std::min(PERIODS, DEPTH) - 1)) % m_slots.size()];
+        if (slot.isOccupied) {
+            increment(m_statistics.late);
+        } else {
+            slot.isOccupied = true;
+            slot.readings   = readings;
+            slot.tp         = tp;
+            slot.push       = m_pushes;
+            m_heldCount++;
+        }
+        // Release the packets that follow the released time without a gap.
+        while (m_slots[m_next].isOccupied) {
+            advance();
+        }
+    }
+}
+
+void OxTSReorderWindow::expire(const std::chrono::system_clock::time_point &now) noexcept {
+    if (0 == m_heldCount) {
+        return;
+    }
+    m_pushes++;
+    while (0 < m_heldCount) {
+        std::size_t oldest{m_next};
+        while (!m_slots[oldest].isOccupied) {
+            oldest = (oldest + 1) % m_slots.size();
+        }
+        if (now - m_slots[oldest].tp < m_timeout) {
+            break;
+        }
+        // Give up on the missing packets before the oldest held one.
+        while (!m_slots[m_next].isOccupied) {
+            advance();
+        }
+        while (m_slots[m_next].isOccupied) {
+            advance();
+        }
+    }
+}
+
+void OxTSReorderWindow::flush() noexcept {
+    m_pushes++;
+    while (0 < m_heldCount) {
+        advance();
+    }
+}
+
+void OxTSReorderWindow::advance() noexcept {
+    Slot &slot = m_slots[m_next];
+    m_next     = (m_next + 1) % m_slots.size();
+    m_released = static_cast<uint16_t>((m_released + m_period) % static_cast<int32_t>(ncom::MILLISECONDS_PER_MINUTE));
+    if (slot.isOccupied) {
+        const bool IS_HELD{slot.push != m_pushes};
+        if (IS_HELD) {
+            increment(m_statistics.held);
+        }
+        slot.isOccupied = false;
+        m_heldCount--;
+        m_released = slot.readings.time;
+        release(slot.readings, slot.tp, IS_HELD);
+    }
+}
+
+void OxTSReorderWindow::release(const OxTSDecoder::Readings &readings, const std::chrono::system_clock::time_point &tp, bool isHeld) noexcept {
+    if (nullptr != m_delegate) {
+        m_delegate(readings, tp, isHeld);
+    }
+}
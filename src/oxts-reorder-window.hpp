@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_REORDER_WINDOW
+#define OXTS_REORDER_WINDOW
+
+#include "oxts-decoder.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * Restores the order of a unit's decoded packets by their NCOM time before
+ * they are published, so that consumers see monotonic sample times: Packets
+ * that follow the previously released one are released right away; after a
+ * gap, later packets are held until the missing ones arrive or until the
+ * window of depth periods is exceeded. Packets that arrive after their
+ * period was released, including duplicates, are dropped.
+ *
+ * Packets are released when later packets arrive or, if the unit stalls,
+ * once they were held for depth periods (see expire()); flush() releases the
+ * held packets at once. A depth of 0 releases every packet unchanged.
+ *
+ * Not thread-safe: push() is meant to be called from a single thread.
+ */
+class OxTSReorderWindow {
+   private:
+    OxTSReorderWindow(const OxTSReorderWindow &) = delete;
+    OxTSReorderWindow(OxTSReorderWindow &&)      = delete;
+    OxTSReorderWindow &operator=(const OxTSReorderWindow &) = delete;
+    OxTSReorderWindow &operator=(OxTSReorderWindow &&) = delete;
+
+   public:
+    /**
+     * Delegate to handle a released packet; readings are only valid during the call.
+     * Parameters are the readings, the receive time as passed to push(), and
+     * whether the packet was held (false for the packet being pushed).
+     */
+    using Delegate = std::function<void(const OxTSDecoder::Readings &, const std::chrono::system_clock::time_point &, bool)>;
+
+    /**
+     * Counters updated by push(); safe to be read from other threads.
+     */
+    struct Statistics {
+        // Packets released after waiting for earlier ones.
+        std::atomic<uint64_t> held{0};
+        // Packets dropped as their period was already released.
+        std::atomic<uint64_t> late{0};
+    };
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param depth Number of periods to wait for missing packets; 0 disables reordering.
+     * @param period Time between two packets at the unit's output rate.
+     * @param delegate Function to be called for every released packet.
+     */
+    OxTSReorderWindow(std::size_t depth, std::chrono::milliseconds period, Delegate delegate) noexcept;
+    ~OxTSReorderWindow() = default;
+
+    /**
+     * This method adds a decoded packet; readings without a valid NCOM time are released right away.
+     *
+     * @param readings Readings of the packet.
+     * @param tp Receive time of the packet.
+     */
+    void push(const OxTSDecoder::Readings &readings, const std::chrono::system_clock::time_point &tp) noexcept;
+
+    /**
+     * This method gives up on missing packets once the oldest held packet
+     * was received depth periods ago, and releases the held packets that
+     * follow it without a gap; it is meant to be called periodically.
+     *
+     * @param now Current time on the clock of the receive times.
+     */
+    void expire(const std::chrono::system_clock::time_point &now) noexcept;
+
+    /**
+     * This method releases all held packets in order.
+     */
+    void flush() noexcept;
+
+    /**
+     * @return Counters for held and late packets.
+     */
+    const Statistics &statistics() const noexcept;
+
+   private:
+    struct Slot {
+        bool isOccupied{false};
+        OxTSDecoder::Readings readings{};
+        std::chrono::system_clock::time_point tp{};
+        // Value of m_pushes when the packet was added.
+        uint64_t push{0};
+    };
+
+    // Releases the next slot if occupied and moves the window on by one period.
+    void advance() noexcept;
+    void release(const OxTSDecoder::Readings &readings, const std::chrono::system_clock::time_point &tp, bool isHeld) noexcept;
+
+   private:
+    const int32_t m_period;
+    // Time after which held packets are released regardless of missing ones.
+    const std::chrono::system_clock::duration m_timeout;
+    Delegate m_delegate;
+    Statistics m_statistics{};
+
+    // m_slots[(m_next + i) % depth] holds the packet i + 1 periods after the released time.
+    std::vector<Slot> m_slots;
+    std::size_t m_next{0};
+    std::size_t m_heldCount{0};
+    // Number of calls to push() to tell held packets from immediately released ones.
+    uint64_t m_pushes{0};
+    bool m_hasReleased{false};
+    uint16_t m_released{0};
+};
+
+#endif
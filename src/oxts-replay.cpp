@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cluon-complete.hpp"
+#include "opendlv-standard-message-set.hpp"
+
+#include "oxts-black-box.hpp"
+#include "oxts-decoder.hpp"
+#include "oxts-forwarder.hpp"
+#include "oxts-framer.hpp"
+#include "oxts-latency.hpp"
+#include "oxts-ncom.hpp"
+#include "oxts-publisher.hpp"
+#include "oxts-recording.hpp"
+#include "oxts-status-reporter.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+// Sets up a serial port for raw 8N1 input; @return false for unsupported rates.
+bool configureSerial(int fd, uint32_t baud) noexcept {
+    speed_t speed{B0};
+    switch (baud) {
+        case 9600: speed = B9600; break;
+        case 19200: speed = B19200; break;
+        case 38400: speed = B38400; break;
+        case 57600: speed = B57600; break;
+        case 115200: speed = B115200; break;
+        case 230400: speed = B230400; break;
+        case 460800: speed = B460800; break;
+        case 921600: speed = B921600; break;
+        default: return false;
+    }
+    struct termios settings {};
+    if (0 != ::tcgetattr(fd, &settings)) {
+        return false;
+    }
+    ::cfmakeraw(&settings);
+    settings.c_cflag |= (CLOCAL | CREAD);
+    return (0 == ::cfsetispeed(&settings, speed)) && (0 == ::cfsetospeed(&settings, speed))
+           && (0 == ::tcsetattr(fd, TCSANOW, &settings));
+}
+} // namespace
+
+int32_t main(int32_t argc, char **argv) {
+    int32_t retCode{0};
+    const std::string PROGRAM(argv[0]);
+    argh::parser commandline(argc, argv);
+
+    const std::string SPEED{commandline("speed", "1").str()};
+    double speed{1.0};
+    commandline("speed", 1.0) >> speed;
+    const bool AS_FAST_AS_POSSIBLE{"max" == SPEED};
+
+    if ( (3 != commandline.pos_args().size()) || (!AS_FAST_AS_POSSIBLE && !(0.0 < speed)) ) {
+        std::cerr << PROGRAM << " replays a recorded NCOM file (the raw packets as sent by an OXTS GPS/INSS unit or a ring file recorded by oxts --record) or reads NCOM from a serial port or pipe and publishes its decoded readings to a running OpenDaVINCI session using the OpenDLV Standard Message Set." << std::endl;
+        std::cerr << "Usage:   " << PROGRAM << " <file.ncom>|<serial port> <OpenDaVINCI session> [--speed=<factor>|max] [--sender-stamp=<id>] [--unit=<index>] [--baud=<rate>] [--verbose=<level>] [--interval=<seconds>] [--navigation=locked|any]" << std::endl;
+        std::cerr << "         --speed:        1: original timing (default), <factor>: scaled timing, max: as fast as possible" << std::endl;
+        std::cerr << "         --sender-stamp: senderStamp of the published messages (default: 0)" << std::endl;
+        std::cerr << "         --unit:         unit to replay from a ring file recorded by oxts --record (default: 0)" << std::endl;
+        std::cerr << "         --baud:         rate of a serial port given instead of a file (default: 115200)" << std::endl;
+        std::cerr << "         --verbose:      0: quiet, 1: periodic summary (default), 2: summary with drop reasons" << std::endl;
+        std::cerr << "         --interval:     time between two summaries (default: 10)" << std::endl;
+        std::cerr << "         --navigation:   publish positions only while the unit is locked (default) or regardless of its navigation status" << std::endl;
+        std::cerr << "Example: " << PROGRAM << " drive.ncom 111 --speed=max --verbose=2 --interval=1" << std::endl;
+        std::cerr << "         " << PROGRAM << " /dev/ttyUSB0 111 --baud=115200" << std::endl;
+        retCode = 1;
+    } else {
+        // Serial ports and pipes (e.g. /dev/stdin) are framed as they are read; files are mapped.
+        const std::string INPUT{commandline[1]};
+        struct stat info {};
+        const bool IS_STREAM{(0 == ::stat(INPUT.c_str(), &info)) && !S_ISREG(info.st_mode)};
+        int fd{-1};
+        std::unique_ptr<OxTSRecording> recording;
+        bool isOpen{false};
+        if (IS_STREAM) {
+            uint32_t baud{115200};
+            commandline("baud", 115200) >> baud;
+            fd = ::open(INPUT.c_str(), O_RDONLY | O_NOCTTY | O_CLOEXEC);
+            if (0 > fd) {
+                std::cerr << "[oxts-replay] Failed to open " << INPUT << ": " << ::strerror(errno) << std::endl;
+            } else if (::isatty(fd) && !configureSerial(fd, baud)) {
+                std::cerr << "[oxts-replay] Failed to configure " << INPUT << " for " << baud << " baud." << std::endl;
+                ::close(fd);
+            } else {
+                isOpen = true;
+            }
+        } else {
+            // The file is paged in on demand while replaying.
+            recording.reset(new OxTSRecording(INPUT));
+            isOpen = recording->isOpen();
+        }
+
+        if (!isOpen) {
+            retCode = 1;
+        } else {
+            uint32_t verbosity{OxTSStatusReporter::SUMMARY};
+            commandline("verbose", OxTSStatusReporter::SUMMARY) >> verbosity;
+            uint32_t interval{10};
+            commandline("interval", 10) >> interval;
+            uint32_t senderStamp{0};
+            commandline("sender-stamp", 0) >> senderStamp;
+            uint32_t unit{0};
+            commandline("unit", 0) >> unit;
+            const uint32_t UNIT{unit};
+            const OxTSDecoder::Gating GATING{("any" == commandline("navigation", "locked").str()) ? OxTSDecoder::Gating::NONE : OxTSDecoder::Gating::LOCKED};
+
+            // Interface to a running OpenDaVINCI session (ignoring any incoming Envelopes).
+            const uint16_t CID{static_cast<uint16_t>(std::stoi(commandline[2]))};
+            cluon::OD4Session od4{CID,
+                [](auto){}
+            };
+            od4::Publisher publisher{CID};
+
+            OxTSDecoder decoder{GATING};
+            OxTSForwarder forwarder{publisher, od4, senderStamp};
+            // Time between decoding a packet and its readings being sent.
+            LatencyHistogram decodeToPublish;
+            OxTSStatusReporter reporter(decoder, decodeToPublish, verbosity, std::chrono::seconds{interval});
+
+            // Gaps in the recording (e.g. several concatenated drives) are not waited for.
+            constexpr std::chrono::nanoseconds MAX_GAP{std::chrono::seconds{1}};
+            const std::chrono::steady_clock::time_point START{std::chrono::steady_clock::now()};
+            std::chrono::duration<double, std::nano> recorded{0};
+            uint64_t packets{0};
+            std::size_t skipped{0};
+            std::size_t bytes{0};
+
+            auto publish = [&](const uint8_t *packet, std::size_t length, std::chrono::nanoseconds sincePrevious) {
+                if (!AS_FAST_AS_POSSIBLE) {
+                    if ( (0 < packets) && (std::chrono::nanoseconds::zero() <= sincePrevious) && (sincePrevious <= MAX_GAP) ) {
+                        recorded += sincePrevious;
+                    }
+                    std::this_thread::sleep_until(START + std::chrono::duration_cast<std::chrono::steady_clock::duration>(recorded / speed));
+                }
+
+                const std::chrono::system_clock::time_point NOW{std::chrono::system_clock::now()};
+                OxTSDecoder::Readings readings;
+                decoder.decode(packet, length, readings);
+                if (forwarder.forward(readings, decoder.status(), cluon::time::convert(NOW), NOW)) {
+                    decodeToPublish.record(std::chrono::system_clock::now() - NOW);
+                }
+                if (0 != (readings.batches & OxTSDecoder::BATCH_B)) {
+                    reporter.update(readings.position.latitude(), readings.position.longitude(), readings.heading.northHeading());
+                }
+                packets++;
+            };
+
+            if (IS_STREAM) {
+                // Live sources are published as the frames arrive.
+                OxTSFramer framer{[&publish](const uint8_t *frame, std::size_t length) {
+                    publish(frame, length, std::chrono::nanoseconds::zero());
+                }};
+                std::array<uint8_t, 4096> buffer;
+                struct pollfd input {fd, POLLIN, 0};
+                while (od4.isRunning()) {
+                    const int READY{::poll(&input, 1, 1000)};
+                    if (0 >= READY) {
+                        if ( (0 > READY) && (EINTR != errno) ) {
+                            break;
+                        }
+                        continue;
+                    }
+                    const ssize_t LENGTH{::read(fd, buffer.data(), buffer.size())};
+                    if (0 >= LENGTH) {
+                        if ( (0 > LENGTH) && ((EINTR == errno) || (EAGAIN == errno)) ) {
+                            continue;
+                        }
+                        break;
+                    }
+                    bytes += static_cast<std::size_t>(LENGTH);
+                    framer.push(buffer.data(), static_cast<std::size_t>(LENGTH));
+                }
+                skipped = static_cast<std::size_t>(framer.statistics().skipped);
+                ::close(fd);
+            } else if (OxTSBlackBox::isRingFile(recording->begin(), recording->size())) {
+                // Ring files written by oxts --record are paced by their kernel receive times.
+                std::chrono::nanoseconds previous{0};
+                for (const blackbox::Record *record : OxTSBlackBox::chronological(recording->begin(), recording->size())) {
+                    if (!od4.isRunning()) {
+                        break;
+                    }
+                    if (UNIT != record->unit) {
+                        continue;
+                    }
+                    const std::chrono::nanoseconds RECEIVED{record->received};
+                    publish(record->packet.data(), std::min<std::size_t>(record->length, ncom::PACKET_LENGTH), RECEIVED - previous);
+                    previous = RECEIVED;
+                }
+            } else {
+                const uint8_t *packet{recording->begin()};
+                uint16_t previous{0};
+                while (od4.isRunning()) {
+                    const uint8_t *next{OxTSRecording::findPacket(packet, recording->end())};
+                    skipped += static_cast<std::size_t>(next - packet);
+                    if (recording->end() == next) {
+                        break;
+                    }
+                    packet = next;
+
+                    // Raw files are paced by the packets' NCOM time (milliseconds within the current GPS minute).
+                    const uint16_t TIME{ncom::raw<ncom::Time>(packet)};
+                    publish(packet, ncom::PACKET_LENGTH, std::chrono::milliseconds{(TIME + ncom::MILLISECONDS_PER_MINUTE - previous) % ncom::MILLISECONDS_PER_MINUTE});
+                    previous = TIME;
+                    packet += ncom::PACKET_LENGTH;
+                }
+            }
+
+            const std::chrono::duration<double> ELAPSED{std::chrono::steady_clock::now() - START};
+            std::cout << "[oxts-replay] " << packets << " packets in " << std::fixed << std::setprecision(3) << ELAPSED.count() << " s ("
+                      << std::setprecision(1) << ((0.0 < ELAPSED.count()) ? static_cast<double>(packets) / ELAPSED.count() : 0.0) << " packets/s), "
+                      << skipped << " of " << (IS_STREAM ? bytes : recording->size()) << " bytes skipped" << std::endl;
+        }
+    }
+    return retCode;
+}
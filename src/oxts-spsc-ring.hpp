@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_SPSC_RING
+#define OXTS_SPSC_RING
+
+#include "oxts-counters.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+namespace spsc {
+
+/**
+ * Behavior of Ring::push() when the ring is full.
+ */
+enum class Overflow : uint8_t {
+    DROP_NEWEST, // Discard the element to be pushed and count it as dropped.
+    BLOCK,       // Wait until the consumer has made room.
+};
+
+/**
+ * Counters of a Ring; safe to be read from any thread.
+ */
+struct Statistics {
+    std::atomic<uint64_t> pushed{0};
+    std::atomic<uint64_t> popped{0};
+    std::atomic<uint64_t> dropped{0};
+    // Largest number of elements queued at once.
+    std::atomic<uint64_t> maxDepth{0};
+
+    /**
+     * @return Number of currently queued elements.
+     */
+    uint64_t depth() const noexcept {
+        const uint64_t POPPED{popped.load(std::memory_order_relaxed)};
+        const uint64_t PUSHED{pushed.load(std::memory_order_relaxed)};
+        return (PUSHED > POPPED) ? PUSHED - POPPED : 0;
+    }
+};
+
+/**
+ * Bounded lock-free queue for exactly one producing and one consuming
+ * thread. Elements are stored in place; head and tail live on separate
+ * cache lines and each side caches the other side's index to avoid
+ * touching the shared cache line on every operation.
+ *
+ * @tparam T Element type; must be default constructible and copy assignable.
+ * @tparam CAPACITY Number of elements; must be a power of two.
+ */
+template <typename T, std::size_t CAPACITY>
+class Ring {
+    static_assert((0 < CAPACITY) && (0 == (CAPACITY & (CAPACITY - 1))), "CAPACITY must be a power of two.");
+
+   private:
+    Ring(const Ring &) = delete;
+    Ring(Ring &&)      = delete;
+    Ring &operator=(const Ring &) = delete;
+    Ring &operator=(Ring &&) = delete;
+
+   public:
+    explicit Ring(Overflow overflow = Overflow::DROP_NEWEST) noexcept
+        : m_overflow(overflow) {}
+
+    /**
+     * This method is to be called by the producer only.
+     *
+     * @param element Element to enqueue.
+     * @param isRunning Polled while blocking; push() gives up and drops the element once it turns false.
+     * @return true if the element was enqueued, false if it was dropped.
+     */
+    bool push(const T &element, const std::atomic<bool> *isRunning = nullptr) noexcept {
+        const std::size_t TAIL{m_tail.load(std::memory_order_relaxed)};
+        if (CAPACITY == TAIL - m_cachedHead) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            while ( (CAPACITY == TAIL - m_cachedHead) && (Overflow::BLOCK == m_overflow)
+                    && ((nullptr == isRunning) || isRunning->load(std::memory_order_relaxed)) ) {
+                std::this_thread::yield();
+                m_cachedHead = m_head.load(std::memory_order_acquire);
+            }
+            if (CAPACITY == TAIL - m_cachedHead) {
+                counters::increment(m_statistics.dropped);
+                return false;
+            }
+        }
+
+        m_slots[TAIL & (CAPACITY - 1)] = element;
+        m_tail.store(TAIL + 1, std::memory_order_release);
+
+        counters::increment(m_statistics.pushed);
+        const uint64_t DEPTH{static_cast<uint64_t>(TAIL + 1 - m_cachedHead)};
+        if (DEPTH > m_statistics.maxDepth.load(std::memory_order_relaxed)) {
+            m_statistics.maxDepth.store(DEPTH, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    /**
+     * This method is to be called by the consumer only.
+     *
+     * @return Pointer to the oldest element or nullptr if empty; valid until pop().
+     */
+    const T *front() noexcept {
+        const std::size_t HEAD{m_head.load(std::memory_order_relaxed)};
+        if (HEAD == m_cachedTail) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (HEAD == m_cachedTail) {
+                return nullptr;
+            }
+        }
+        return &m_slots[HEAD & (CAPACITY - 1)];
+    }
+
+    /**
+     * This method removes the element returned by front(); to be called by the consumer only.
+     */
+    void pop() noexcept {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        m_statistics.popped.store(m_statistics.popped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @return true if no element is queued; may be called from any thread.
+     */
+    bool empty() const noexcept {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    const Statistics &statistics() const noexcept {
+        return m_statistics;
+    }
+
+    static constexpr std::size_t capacity() noexcept {
+        return CAPACITY;
+    }
+
+   private:
+    static constexpr std::size_t CACHE_LINE{64};
+
+    const Overflow m_overflow;
+    std::array<T, CAPACITY> m_slots{};
+
+    // Written by the consumer.
+    alignas(CACHE_LINE) std::atomic<std::size_t> m_head{0};
+    std::size_t m_cachedTail{0};
+
+    // Written by the producer.
+    alignas(CACHE_LINE) std::atomic<std::size_t> m_tail{0};
+    std::size_t m_cachedHead{0};
+
+    alignas(CACHE_LINE) Statistics m_statistics{};
+};
+
+} // namespace spsc
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "oxts-stages.hpp"
+
+#include <sstream>
+
+namespace stages {
+
+Latencies::Latencies() noexcept {
+#ifdef OXTS_STAGES_TSC
+    // The counter's rate is constant on all CPUs since Nehalem; measure it against steady_clock.
+    const auto START{std::chrono::steady_clock::now()};
+    const Ticks FIRST{now()};
+    auto end{START};
+    do {
+        end = std::chrono::steady_clock::now();
+    } while (end - START < std::chrono::milliseconds{10});
+    const Ticks LAST{now()};
+    if (LAST > FIRST) {
+        m_nanosecondsPerTick = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - START).count()) / static_cast<double>(LAST - FIRST);
+    }
+#endif
+}
+
+const LatencyHistogram &Latencies::histogram(Stage stage) const noexcept {
+    return m_histograms[(stage < STAGES) ? stage : TOTAL];
+}
+
+std::string Latencies::summary() const {
+    std::stringstream sstr;
+    if (ENABLED && (0 < m_histograms[TOTAL].count())) {
+        sstr << "stages p50/p99/p99.9/max = ";
+        for (uint32_t i{RECEIVE}; i < STAGES; i++) {
+            const LatencyHistogram &h{m_histograms[i]};
+            sstr << ((RECEIVE == i) ? "" : ", ") << name(static_cast<Stage>(i)) << ' ' << h.percentile(50.0).count() << '/'
+                 << h.percentile(99.0).count() << '/' << h.percentile(99.9).count() << '/' << h.max().count();
+        }
+        sstr << " ns";
+    }
+    return sstr.str();
+}
+
+const char *Latencies::name(Stage stage) noexcept {
+    switch (stage) {
+        case RECEIVE: return "receive";
+        case DECODE: return "decode";
+        case SERIALIZE: return "serialize";
+        case SEND: return "send";
+        case TOTAL: return "total";
+        default: return "unknown";
+    }
+}
+
+} // namespace stages
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_STAGES
+#define OXTS_STAGES
+
+#include "oxts-latency.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#if defined(OXTS_STAGE_TIMING) && (defined(__x86_64__) || defined(__i386__))
+    #define OXTS_STAGES_TSC
+    #include <x86intrin.h>
+#endif
+
+/**
+ * Per-stage latencies of the packets between the kernel receiving a
+ * datagram and the Publisher handing its frames back to the kernel.
+ *
+ * Time points are taken with stages::now(), which reads the time stamp
+ * counter on x86 (a few ns instead of a clock_gettime call) and steady_clock
+ * elsewhere. As even four reads of the counter cost more than the budget of
+ * the instrumentation on some machines, only every SAMPLING-th packet is
+ * timed by stage; the total is recorded for every packet. Without
+ * OXTS_STAGE_TIMING (CMake option of the same name), no packet is sampled,
+ * now() returns 0, and Latencies::record() only keeps the total, so that the
+ * instrumentation is removed by the compiler.
+ */
+namespace stages {
+
+#ifdef OXTS_STAGE_TIMING
+constexpr bool ENABLED{true};
+#else
+constexpr bool ENABLED{false};
+#endif
+
+// One in this many packets is timed by stage.
+constexpr uint32_t SAMPLING{16};
+static_assert(0 == (SAMPLING & (SAMPLING - 1)), "SAMPLING must be a power of two.");
+
+enum Stage : uint32_t {
+    RECEIVE   = 0, // Kernel receive time stamp until decoding starts: queueing and scheduling.
+    DECODE    = 1,
+    SERIALIZE = 2, // Encoding the readings into OD4 frames.
+    SEND      = 3, // Handing the frames to the kernel.
+    TOTAL     = 4, // Kernel receive time stamp until the frames were sent.
+    STAGES    = 5,
+};
+
+using Ticks = uint64_t;
+
+/**
+ * @return Monotonic time in ticks of an unspecified length; 0 if compiled out.
+ */
+inline Ticks now() noexcept {
+#if defined(OXTS_STAGES_TSC)
+    return __rdtsc();
+#elif defined(OXTS_STAGE_TIMING)
+    return static_cast<Ticks>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Time points of one packet taken with now(); only set if the packet is sampled.
+ */
+struct Marks {
+    bool isSampled{false};
+    Ticks decodeStart{0};
+    Ticks decodeEnd{0};
+    Ticks serializeEnd{0};
+    Ticks sendEnd{0};
+};
+
+/**
+ * One LatencyHistogram per stage; begin() and record() are meant to be called
+ * from the publishing thread and all other methods may be called concurrently.
+ */
+class Latencies {
+   private:
+    Latencies(const Latencies &) = delete;
+    Latencies(Latencies &&)      = delete;
+    Latencies &operator=(const Latencies &) = delete;
+    Latencies &operator=(Latencies &&) = delete;
+
+   public:
+    /**
+     * Constructor; calibrates the length of a tick for about 10 ms when using the time stamp counter.
+     */
+    Latencies() noexcept;
+    ~Latencies() = default;
+
+    /**
+     * This method decides whether the next packet is sampled and, if so, takes its first time point.
+     *
+     * @param marks Time points of the packet; the others are to be taken only if it is sampled.
+     * @return true if the packet is sampled.
+     */
+    bool begin(Marks &marks) noexcept {
+        marks.isSampled = ENABLED && (0 == (m_packets++ & (SAMPLING - 1)));
+        if (marks.isSampled) {
+            marks.decodeStart = now();
+        }
+        return marks.isSampled;
+    }
+
+    /**
+     * This method adds the stages of a published packet.
+     *
+     * @param marks Time points of the packet; only sampled packets are broken down by stage.
+     * @param total Time between the kernel's receive time stamp and marks.sendEnd; recorded even if compiled out.
+     */
+    void record(const Marks &marks, std::chrono::nanoseconds total) noexcept {
+        if (ENABLED && marks.isSampled) {
+            const std::chrono::nanoseconds DECODE_NS{between(marks.decodeStart, marks.decodeEnd)};
+            const std::chrono::nanoseconds SERIALIZE_NS{between(marks.decodeEnd, marks.serializeEnd)};
+            const std::chrono::nanoseconds SEND_NS{between(marks.serializeEnd, marks.sendEnd)};
+            m_histograms[RECEIVE].record(total - DECODE_NS - SERIALIZE_NS - SEND_NS);
+            m_histograms[DECODE].record(DECODE_NS);
+            m_histograms[SERIALIZE].record(SERIALIZE_NS);
+            m_histograms[SEND].record(SEND_NS);
+        }
+        m_histograms[TOTAL].record(total);
+    }
+
+    /**
+     * @return Histogram of the given stage.
+     */
+    const LatencyHistogram &histogram(Stage stage) const noexcept;
+
+    /**
+     * @return p50/p99/p99.9/max per stage in ns; empty if nothing was recorded or if compiled out.
+     */
+    std::string summary() const;
+
+    /**
+     * @return Human-readable name of the given stage.
+     */
+    static const char *name(Stage stage) noexcept;
+
+   private:
+    std::chrono::nanoseconds between(Ticks from, Ticks to) const noexcept {
+        return std::chrono::nanoseconds{(to > from) ? static_cast<int64_t>(static_cast<double>(to - from) * m_nanosecondsPerTick) : 0};
+    }
+
+   private:
+    double m_nanosecondsPerTick{1.0};
+    uint32_t m_packets{0};
+    std::array<LatencyHistogram, STAGES> m_histograms{};
+};
+
+} // namespace stages
+
+#endif
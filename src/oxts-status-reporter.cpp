@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "oxts-status-reporter.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+OxTSStatusReporter::OxTSStatusReporter(const OxTSDecoder &decoder,
+                                       const LatencyHistogram &latency,
+                                       uint32_t verbosity,
+                                       std::chrono::milliseconds interval,
+                                       std::ostream &out) noexcept
+    : OxTSStatusReporter(std::vector<const OxTSDecoder *>{&decoder}, latency, verbosity, interval, out) {}
+
+OxTSStatusReporter::OxTSStatusReporter(const std::vector<const OxTSDecoder *> &decoders,
+                                       const LatencyHistogram &latency,
+                                       uint32_t verbosity,
+                                       std::chrono::milliseconds interval,
+                                       std::ostream &out) noexcept
+    : m_units(decoders.size())
+    , m_latency(latency)
+    , m_verbosity(verbosity)
+    , m_interval(interval)
+    , m_out(out) {
+    for (std::size_t i{0}; i < decoders.size(); i++) {
+        m_units[i].decoder = decoders[i];
+    }
+    if ( (QUIET < m_verbosity) && (0 < m_interval.count()) ) {
+        // Constructing a thread could fail.
+        try {
+            m_reportThread = std::thread(&OxTSStatusReporter::report, this);
+        } catch (...) {
+            std::cerr << "[OxTSStatusReporter] Failed to start reporting thread." << std::endl;
+        }
+    }
+}
+
+OxTSStatusReporter::~OxTSStatusReporter() noexcept {
+    stop();
+}
+
+void OxTSStatusReporter::stop() noexcept {
+    {
+        std::lock_guard<std::mutex> lck(m_stopMutex);
+        m_stop = true;
+    }
+    m_stopCondition.notify_all();
+
+    // Joining the thread could fail.
+    try {
+        if (m_reportThread.joinable()) {
+            m_reportThread.join();
+        }
+    } catch (...) {}
+}
+
+void OxTSStatusReporter::update(double latitude, double longitude, float northHeading) noexcept {
+    update(0, latitude, longitude, northHeading);
+}
+
+void OxTSStatusReporter::update(uint32_t unit, double latitude, double longitude, float northHeading) noexcept {
+    if (unit < m_units.size()) {
+        Unit &u = m_units[unit];
+        const uint64_t SEQUENCE{u.sequence.load(std::memory_order_relaxed)};
+        u.sequence.store(SEQUENCE + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        u.latitude.store(latitude, std::memory_order_relaxed);
+        u.longitude.store(longitude, std::memory_order_relaxed);
+        u.northHeading.store(northHeading, std::memory_order_relaxed);
+        u.sequence.store(SEQUENCE + 2, std::memory_order_release);
+    }
+}
+
+void OxTSStatusReporter::watch(const spsc::Statistics &queue) noexcept {
+    m_queue.store(&queue);
+}
+
+void OxTSStatusReporter::watch(uint32_t unit, const ClockOffsetEstimator::Health &clock) noexcept {
+    if (unit < m_units.size()) {
+        m_units[unit].clock.store(&clock);
+    }
+}
+
+void OxTSStatusReporter::watch(uint32_t unit, const OxTSReorderWindow::Statistics &window) noexcept {
+    if (unit < m_units.size()) {
+        m_units[unit].window.store(&window);
+    }
+}
+
+void OxTSStatusReporter::watch(const stages::Latencies &stages) noexcept {
+    m_stages.store(&stages);
+}
+
+void OxTSStatusReporter::summarize(std::ostream &buffer, Unit &unit, double seconds) noexcept {
+    const OxTSDecoder::Statistics &s{unit.decoder->statistics()};
+    const uint64_t PACKETS{s.packets.load(std::memory_order_relaxed)};
+    const uint64_t CHECKSUMS{s.invalidChecksum1.load(std::memory_order_relaxed)
+                             + s.invalidChecksum2.load(std::memory_order_relaxed)
+                             + s.invalidChecksum3.load(std::memory_order_relaxed)};
+    const double RATE{(0.0 < seconds) ? static_cast<double>(PACKETS - unit.previousPackets) / seconds : 0.0};
+    unit.previousPackets = PACKETS;
+
+    buffer << std::fixed << std::setprecision(1) << RATE << " packets/s, " << PACKETS << " packets, "
+           << s.rejected.load(std::memory_order_relaxed) << " rejected, " << CHECKSUMS << " checksum errors";
+    if (DETAILED <= m_verbosity) {
+        buffer << " (length: " << s.invalidLength.load(std::memory_order_relaxed)
+               << ", sync: " << s.invalidSync.load(std::memory_order_relaxed)
+               << ", checksum 1/2/3: " << s.invalidChecksum1.load(std::memory_order_relaxed) << '/'
+               << s.invalidChecksum2.load(std::memory_order_relaxed) << '/'
+               << s.invalidChecksum3.load(std::memory_order_relaxed)
+               << ", navigation: " << s.gated.load(std::memory_order_relaxed) << ')';
+    }
+
+    buffer << ", " << s.missing.load(std::memory_order_relaxed) << " missing";
+    if (DETAILED <= m_verbosity) {
+        buffer << " (duplicates: " << s.duplicates.load(std::memory_order_relaxed)
+               << ", reordered: " << s.reordered.load(std::memory_order_relaxed);
+        const OxTSReorderWindow::Statistics *window{unit.window.load()};
+        if (nullptr != window) {
+            buffer << ", held: " << window->held.load(std::memory_order_relaxed)
+                   << ", late: " << window->late.load(std::memory_order_relaxed);
+        }
+        buffer << ')';
+    }
+
+    // Retry while update() writes a new fix.
+    uint64_t sequence{0};
+    double latitude{0.0};
+    double longitude{0.0};
+    float northHeading{0.0f};
+    for (bool isConsistent{false}; !isConsistent;) {
+        sequence     = unit.sequence.load(std::memory_order_acquire);
+        latitude     = unit.latitude.load(std::memory_order_relaxed);
+        longitude    = unit.longitude.load(std::memory_order_relaxed);
+        northHeading = unit.northHeading.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        isConsistent = (0 == (sequence & 1)) && (sequence == unit.sequence.load(std::memory_order_relaxed));
+    }
+    if (0 < sequence) {
+        buffer << std::setprecision(7) << ", last fix: latitude = " << latitude
+               << ", longitude = " << longitude << std::setprecision(4)
+               << ", northHeading = " << northHeading;
+    } else {
+        buffer << ", no fix";
+    }
+
+    const ClockOffsetEstimator::Health *clock{unit.clock.load()};
+    if (nullptr != clock) {
+        if (clock->isLocked.load(std::memory_order_relaxed)) {
+            using std::chrono::duration_cast;
+            using std::chrono::microseconds;
+            using std::chrono::nanoseconds;
+            buffer << ", clock offset = " << std::setprecision(6)
+                   << std::chrono::duration<double>(nanoseconds{clock->offset.load(std::memory_order_relaxed)}).count() << " s"
+                   << std::setprecision(3) << ", drift = " << clock->drift.load(std::memory_order_relaxed) << " ppm"
+                   << ", residual median/max = " << duration_cast<microseconds>(nanoseconds{clock->medianResidual.load(std::memory_order_relaxed)}).count() << '/'
+                   << duration_cast<microseconds>(nanoseconds{clock->maxResidual.load(std::memory_order_relaxed)}).count() << " us";
+        } else {
+            buffer << ", clock unlocked";
+        }
+        if (DETAILED <= m_verbosity) {
+            buffer << " (resets: " << clock->resets.load(std::memory_order_relaxed)
+                   << ", late: " << clock->late.load(std::memory_order_relaxed) << ')';
+        }
+    }
+}
+
+std::string OxTSStatusReporter::summary(std::chrono::steady_clock::duration elapsed) noexcept {
+    const double SECONDS{std::chrono::duration<double>(elapsed).count()};
+    std::stringstream buffer;
+    if (1 == m_units.size()) {
+        buffer << "[oxts] ";
+        summarize(buffer, m_units[0], SECONDS);
+    } else {
+        for (std::size_t i{0}; i < m_units.size(); i++) {
+            buffer << "[oxts] unit " << i << ": ";
+            summarize(buffer, m_units[i], SECONDS);
+            buffer << '\n';
+        }
+        buffer << "[oxts] all units";
+    }
+
+    const spsc::Statistics *queue{m_queue.load()};
+    if (nullptr != queue) {
+        buffer << ", queue depth/max/dropped = " << queue->depth() << '/' << queue->maxDepth.load(std::memory_order_relaxed) << '/'
+               << queue->dropped.load(std::memory_order_relaxed);
+    }
+
+    if (0 < m_latency.count()) {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+        buffer << ", latency p50/p99/p99.9/max = " << duration_cast<microseconds>(m_latency.percentile(50.0)).count() << '/'
+               << duration_cast<microseconds>(m_latency.percentile(99.0)).count() << '/'
+               << duration_cast<microseconds>(m_latency.percentile(99.9)).count() << '/'
+               << duration_cast<microseconds>(m_latency.max()).count() << " us";
+    }
+
+    const stages::Latencies *latencies{m_stages.load()};
+    if ( (nullptr != latencies) && (DETAILED <= m_verbosity) ) {
+        const std::string STAGES{latencies->summary()};
+        if (!STAGES.empty()) {
+            buffer << "\n[oxts] " << STAGES;
+        }
+    }
+    return buffer.str();
+}
+
+void OxTSStatusReporter::report() noexcept {
+    auto previous = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lck(m_stopMutex);
+    while (!m_stopCondition.wait_for(lck, m_interval, [this]() { return m_stop; })) {
+        const auto NOW = std::chrono::steady_clock::now();
+        m_out << summary(NOW - previous) << std::endl;
+        previous = NOW;
+    }
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OXTS_STATUS_REPORTER
+#define OXTS_STATUS_REPORTER
+
+#include "oxts-clock.hpp"
+#include "oxts-decoder.hpp"
+#include "oxts-latency.hpp"
+#include "oxts-reorder-window.hpp"
+#include "oxts-spsc-ring.hpp"
+#include "oxts-stages.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Background thread that periodically prints an aggregated summary of the
+ * decoder's counters, the latest fix, the GPS clock offset, and the
+ * publishing latency. The
+ * receiving thread only stores the latest fix through update(), which
+ * neither formats nor performs any I/O.
+ */
+class OxTSStatusReporter {
+   private:
+    OxTSStatusReporter(const OxTSStatusReporter &) = delete;
+    OxTSStatusReporter(OxTSStatusReporter &&)      = delete;
+    OxTSStatusReporter &operator=(const OxTSStatusReporter &) = delete;
+    OxTSStatusReporter &operator=(OxTSStatusReporter &&) = delete;
+
+   public:
+    enum Verbosity : uint32_t {
+        QUIET    = 0, // No reports.
+        SUMMARY  = 1, // Rate, last fix, drop counts, missing packets, and latency percentiles.
+        DETAILED = 2, // Additionally breaks down the drops by reason, including the navigation status, the sequence, and the latency by stage.
+    };
+
+   public:
+    /**
+     * Constructor; the reporting thread is only started for verbosity > QUIET.
+     *
+     * @param decoder Decoder whose statistics are reported.
+     * @param latency Histogram of socket-to-publish latencies.
+     * @param verbosity Level of detail.
+     * @param interval Time between two reports.
+     * @param out Stream to print the reports to.
+     */
+    OxTSStatusReporter(const OxTSDecoder &decoder,
+                       const LatencyHistogram &latency,
+                       uint32_t verbosity,
+                       std::chrono::milliseconds interval,
+                       std::ostream &out = std::cout) noexcept;
+
+    /**
+     * Constructor for several units, which are reported one per line.
+     *
+     * @param decoders Decoders of the units; index i is reported as unit i.
+     */
+    OxTSStatusReporter(const std::vector<const OxTSDecoder *> &decoders,
+                       const LatencyHistogram &latency,
+                       uint32_t verbosity,
+                       std::chrono::milliseconds interval,
+                       std::ostream &out = std::cout) noexcept;
+    ~OxTSStatusReporter() noexcept;
+
+    /**
+     * This method stops the reporting thread; afterwards, watched objects
+     * are no longer accessed and may be destroyed. Called by the destructor.
+     */
+    void stop() noexcept;
+
+    /**
+     * This method stores the latest published fix of the first unit; it is
+     * meant to be called from a single thread and does neither allocate nor lock.
+     * The fix is published through a sequence lock so that a summary never
+     * mixes the fields of two fixes.
+     */
+    void update(double latitude, double longitude, float northHeading) noexcept;
+
+    /**
+     * This method stores the latest published fix of the given unit.
+     */
+    void update(uint32_t unit, double latitude, double longitude, float northHeading) noexcept;
+
+    /**
+     * This method adds the depth and drops of a queue to the reports.
+     *
+     * @param queue Counters of a queue that outlives this reporter or its stop().
+     */
+    void watch(const spsc::Statistics &queue) noexcept;
+
+    /**
+     * This method adds the GPS clock offset and its residuals to the given unit's reports.
+     *
+     * @param clock Health of an estimator that outlives this reporter or its stop().
+     */
+    void watch(uint32_t unit, const ClockOffsetEstimator::Health &clock) noexcept;
+
+    /**
+     * This method adds the held and late packets of the given unit's reorder window to the detailed reports.
+     *
+     * @param window Counters of a window that outlives this reporter or its stop().
+     */
+    void watch(uint32_t unit, const OxTSReorderWindow::Statistics &window) noexcept;
+
+    /**
+     * This method adds the per-stage latencies to the detailed reports.
+     *
+     * @param stages Histograms that outlive this reporter or its stop().
+     */
+    void watch(const stages::Latencies &stages) noexcept;
+
+    /**
+     * @param elapsed Time since the previous summary to compute the rate.
+     * @return One line per unit summarizing the activity since the previous call.
+     */
+    std::string summary(std::chrono::steady_clock::duration elapsed) noexcept;
+
+   private:
+    struct Unit {
+        const OxTSDecoder *decoder{nullptr};
+        // Odd while update() writes the fix; twice the number of fixes otherwise.
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<double> latitude{0.0};
+        std::atomic<double> longitude{0.0};
+        std::atomic<float> northHeading{0.0f};
+        std::atomic<const ClockOffsetEstimator::Health *> clock{nullptr};
+        std::atomic<const OxTSReorderWindow::Statistics *> window{nullptr};
+        uint64_t previousPackets{0};
+    };
+
+    void report() noexcept;
+    void summarize(std::ostream &buffer, Unit &unit, double seconds) noexcept;
+
+   private:
+    std::vector<Unit> m_units;
+    const LatencyHistogram &m_latency;
+    const uint32_t m_verbosity;
+    const std::chrono::milliseconds m_interval;
+    std::ostream &m_out;
+
+    std::atomic<const spsc::Statistics *> m_queue{nullptr};
+    std::atomic<const stages::Latencies *> m_stages{nullptr};
+
+    std::mutex m_stopMutex{};
+    std::condition_variable m_stopCondition{};
+    bool m_stop{false};
+    std::thread m_reportThread{};
+};
+
+#endif
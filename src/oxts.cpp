@@ -18,65 +18,277 @@
 #include "cluon-complete.hpp"
 #include "opendlv-standard-message-set.hpp"
 
+#include "oxts-black-box.hpp"
+#include "oxts-clock.hpp"
 #include "oxts-decoder.hpp"
+#include "oxts-forwarder.hpp"
+#include "oxts-health.hpp"
+#include "oxts-pipeline.hpp"
+#include "oxts-publisher.hpp"
+#include "oxts-receiver.hpp"
+#include "oxts-reorder-window.hpp"
+#include "oxts-stages.hpp"
+#include "oxts-status-reporter.hpp"
 
+#include <algorithm>
+#include <csignal>
 #include <cstdint>
+#include <deque>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <vector>
+
+namespace {
+std::vector<std::string> split(const std::string &list) {
+    std::vector<std::string> retVal;
+    std::stringstream sstr{list};
+    std::string entry;
+    while (std::getline(sstr, entry, ',')) {
+        retVal.push_back(entry);
+    }
+    return retVal;
+}
+
+// The health of each unit is sent with its senderStamp plus OxTSHealthPublisher::SENDER_STAMP_OFFSET,
+// which must fit into 32 bits and must not be the senderStamp of another unit.
+// @return Description of the first violation or an empty string.
+std::string checkSenderStamps(const std::vector<std::string> &senderStamps) {
+    constexpr uint64_t OFFSET{OxTSHealthPublisher::SENDER_STAMP_OFFSET};
+    std::vector<uint64_t> stamps;
+    for (const auto &senderStamp : senderStamps) {
+        stamps.push_back(std::stoull(senderStamp));
+    }
+    for (const uint64_t STAMP : stamps) {
+        if (UINT32_MAX < STAMP + OFFSET) {
+            return "senderStamp " + std::to_string(STAMP) + " exceeds " + std::to_string(UINT32_MAX - OFFSET) + " and leaves no room for the health senderStamp";
+        }
+        if (stamps.end() != std::find(stamps.begin(), stamps.end(), STAMP + OFFSET)) {
+            return "senderStamp " + std::to_string(STAMP + OFFSET) + " is used by the health of the unit with senderStamp " + std::to_string(STAMP);
+        }
+    }
+    return std::string{};
+}
+
+// Set by SIGUSR1 to print the per-stage latencies.
+volatile std::sig_atomic_t stagesRequested{0};
+void requestStages(int) {
+    stagesRequested = 1;
+}
+} // namespace
 
 int32_t main(int32_t argc, char **argv) {
     int32_t retCode{0};
     const std::string PROGRAM(argv[0]);
-    if (4 != argc) {
-        std::cerr << PROGRAM << " decodes latitude/longitude/heading from an OXTS GPS/INSS unit and publishes it to a running OpenDaVINCI session using the OpenDLV Standard Message Set." << std::endl;
-        std::cerr << "Usage:   " << PROGRAM << " <IPv4-address> <port> <OpenDaVINCI session>" << std::endl;
-        std::cerr << "Example: " << PROGRAM << " 0.0.0.0 3000 111" << std::endl;
+    // Positional arguments (including the program itself) and optional --key=value arguments.
+    argh::parser commandline(argc, argv);
+
+    // Several units can be served at once by listing their ports (and addresses) separated by commas.
+    const std::vector<std::string> PORTS{(4 == commandline.pos_args().size()) ? split(commandline[2]) : std::vector<std::string>{}};
+    std::vector<std::string> addresses{(4 == commandline.pos_args().size()) ? split(commandline[1]) : std::vector<std::string>{}};
+    if (1 == addresses.size()) {
+        addresses.resize(PORTS.size(), addresses.front());
+    }
+    std::vector<std::string> senderStamps{split(commandline("sender-stamps").str())};
+    if (senderStamps.empty()) {
+        for (std::size_t i{0}; i < PORTS.size(); i++) {
+            senderStamps.push_back(std::to_string(i));
+        }
+    }
+
+    const bool IS_USAGE{(4 != commandline.pos_args().size()) || PORTS.empty() || (PORTS.size() != addresses.size()) || (PORTS.size() != senderStamps.size())};
+    const std::string SENDER_STAMP_ERROR{IS_USAGE ? std::string{} : checkSenderStamps(senderStamps)};
+
+    if (IS_USAGE) {
+        std::cerr << PROGRAM << " decodes position, heading, altitude, accelerations, angular rates, and velocities from OXTS GPS/INSS units and publishes it to a running OpenDaVINCI session using the OpenDLV Standard Message Set." << std::endl;
+        std::cerr << "Usage:   " << PROGRAM << " <IPv4-address>[,<IPv4-address>...] <port>[,<port>...] <OpenDaVINCI session> [--sender-stamps=<id>,...] [--verbose=<level>] [--interval=<seconds>] [--overflow=drop|block] [--navigation=locked|any] [--health=<seconds>] [--rate=<Hz>] [--reorder=<packets>] [--record=<file> [--record-minutes=<minutes>]]" << std::endl;
+        std::cerr << "         <port>:          one port per unit; a single address applies to all units" << std::endl;
+        std::cerr << "         --sender-stamps: senderStamp per unit (default: 0, 1, ...); none may equal another's plus " << OxTSHealthPublisher::SENDER_STAMP_OFFSET << " or exceed " << (UINT32_MAX - OxTSHealthPublisher::SENDER_STAMP_OFFSET) << std::endl;
+        std::cerr << "         --verbose:       0: quiet, 1: periodic summary (default), 2: summary with drop reasons and latency per stage (also printed upon SIGUSR1)" << std::endl;
+        std::cerr << "         --interval:      time between two summaries (default: 10)" << std::endl;
+        std::cerr << "         --overflow:      drop newly received packets (default) or block receiving while " << OxTSPipeline::CAPACITY << " packets are waiting to be published" << std::endl;
+        std::cerr << "         --navigation:    publish positions only while the unit is locked (default) or regardless of its navigation status" << std::endl;
+        std::cerr << "         --health:        time between two NetworkStatusMessage/SignalStatusMessage per unit with rates, drops, rejects, and latency, sent with the unit's senderStamp + " << OxTSHealthPublisher::SENDER_STAMP_OFFSET << "; 0 disables (default: 1)" << std::endl;
+        std::cerr << "         --rate:          output rate of the units to detect missing, duplicate, and reordered packets by their NCOM time (default: 100)" << std::endl;
+        std::cerr << "         --reorder:       hold up to this many packets (and periods) per unit after a gap to publish them in order; late packets are dropped (default: 0)" << std::endl;
+        std::cerr << "         --record:        keep the most recent raw packets in the given ring file for oxts-replay" << std::endl;
+        std::cerr << "         --record-minutes: length of the ring at the units' output rate (default: 10)" << std::endl;
+        std::cerr << "Example: " << PROGRAM << " 0.0.0.0 3000 111 --verbose=2 --interval=5" << std::endl;
+        std::cerr << "         " << PROGRAM << " 0.0.0.0 3000,3001 111 --sender-stamps=1,2" << std::endl;
+        retCode = 1;
+    } else if (!SENDER_STAMP_ERROR.empty()) {
+        std::cerr << "[oxts] Invalid --sender-stamps: " << SENDER_STAMP_ERROR << std::endl;
         retCode = 1;
     } else {
-        // Interface to a running OpenDaVINCI session (ignoring any incoming Envelopes).
-        cluon::OD4Session od4{static_cast<uint16_t>(std::stoi(std::string{argv[3]})),
-            [](auto){}
-        };
-
-        // Interface to OxTS.
-        const std::string OXTS_ADDRESS(argv[1]);
-        const std::string OXTS_PORT(argv[2]);
-        OxTSDecoder oxtsDecoder;
-        cluon::UDPReceiver fromOXTS(OXTS_ADDRESS, std::stoi(OXTS_PORT),
-            [&od4Session = od4, &decoder=oxtsDecoder](std::string &&d, std::string &&/*from*/, std::chrono::system_clock::time_point &&tp) noexcept {
-            auto retVal = decoder.decode(d);
-            if (retVal.first) {
-                cluon::data::TimeStamp sampleTime = cluon::time::convert(tp);
-
-                opendlv::proxy::GeodeticWgs84Reading msg1 = retVal.second.first;
-                od4Session.send(msg1, sampleTime);
-
-                opendlv::proxy::GeodeticHeadingReading msg2 = retVal.second.second;
-                od4Session.send(msg2, sampleTime);
-
-                // Print values on console.
-                {
-                    std::stringstream buffer;
-                    msg1.accept([](uint32_t, const std::string &, const std::string &) {},
-                               [&buffer](uint32_t, std::string &&, std::string &&n, auto v) { buffer << n << " = " << v << '\n'; },
-                               []() {});
-                    std::cout << buffer.str() << std::endl;
-
-                    std::stringstream buffer2;
-                    msg2.accept([](uint32_t, const std::string &, const std::string &) {},
-                               [&buffer2](uint32_t, std::string &&, std::string &&n, auto v) { buffer2 << n << " = " << v << '\n'; },
-                               []() {});
-                    std::cout << buffer2.str() << std::endl;
+        uint32_t verbosity{OxTSStatusReporter::SUMMARY};
+        commandline("verbose", OxTSStatusReporter::SUMMARY) >> verbosity;
+        uint32_t interval{10};
+        commandline("interval", 10) >> interval;
+        const spsc::Overflow OVERFLOW_POLICY{("block" == commandline("overflow", "drop").str()) ? spsc::Overflow::BLOCK : spsc::Overflow::DROP_NEWEST};
+        uint32_t rate{1000 / static_cast<uint32_t>(OxTSDecoder::NOMINAL_PERIOD.count())};
+        commandline("rate", rate) >> rate;
+        rate = std::min(std::max(rate, 1u), 1000u);
+        const std::chrono::milliseconds PERIOD{1000 / rate};
+        std::size_t reorderDepth{0};
+        commandline("reorder", 0) >> reorderDepth;
+        uint32_t healthInterval{1};
+        commandline("health", 1) >> healthInterval;
+        const OxTSDecoder::Gating GATING{("any" == commandline("navigation", "locked").str()) ? OxTSDecoder::Gating::NONE : OxTSDecoder::Gating::LOCKED};
+        // Optional black box of the raw packets; recording is a copy into the mapped ring file.
+        std::unique_ptr<OxTSBlackBox> blackBox;
+        if (commandline("record")) {
+            uint32_t minutes{10};
+            commandline("record-minutes", 10) >> minutes;
+            // Dimensioned for the units' output rate.
+            const std::size_t CAPACITY{std::size_t{minutes} * 60 * rate * PORTS.size()};
+            blackBox.reset(new OxTSBlackBox(commandline("record").str(), CAPACITY));
+            if (blackBox->isOpen()) {
+                std::cout << "[oxts] Recording the most recent " << CAPACITY << " packets into " << commandline("record").str()
+                          << " (" << minutes << " minutes at " << rate << " packets/s per unit, " << PORTS.size() << " unit(s))" << std::endl;
+            }
+        }
+
+        if ( (nullptr != blackBox) && !blackBox->isOpen() ) {
+            retCode = 1;
+        } else {
+            // Interface to a running OpenDaVINCI session (ignoring any incoming Envelopes).
+            const uint16_t CID{static_cast<uint16_t>(std::stoi(commandline[3]))};
+            cluon::OD4Session od4{CID,
+                [](auto){}
+            };
+            // Readings of all units are sent from preencoded frames without allocating.
+            od4::Publisher publisher{CID};
+
+            // Interface to OxTS; each unit has its own decoder.
+            std::vector<OxTSReceiver::Endpoint> endpoints;
+            std::vector<uint32_t> stamps;
+            for (std::size_t i{0}; i < PORTS.size(); i++) {
+                endpoints.push_back(OxTSReceiver::Endpoint{addresses[i], static_cast<uint16_t>(std::stoi(PORTS[i]))});
+                stamps.push_back(static_cast<uint32_t>(std::stoul(senderStamps[i])));
+            }
+            std::deque<OxTSDecoder> decoders;
+            std::deque<OxTSForwarder> forwarders;
+            std::vector<const OxTSDecoder *> decoderList;
+            for (std::size_t i{0}; i < endpoints.size(); i++) {
+                decoders.emplace_back(GATING, PERIOD);
+                forwarders.emplace_back(publisher, od4, stamps[i]);
+                decoderList.push_back(&decoders.back());
+            }
+            // GPS time of each unit mapped onto system_clock; used for sampleTimeStamp once locked.
+            // Late packets within the decoder's sequence history do not restart the estimation.
+            std::deque<ClockOffsetEstimator> clocks;
+            for (std::size_t i{0}; i < endpoints.size(); i++) {
+                clocks.emplace_back(PERIOD * static_cast<int64_t>(OxTSDecoder::SEQUENCE_HISTORY));
+            }
+            // Time between the kernel receiving a datagram and its readings being sent, broken down by stage.
+            stages::Latencies stageLatencies;
+            // Console output is formatted by the reporter's thread and upon SIGUSR1 only.
+            OxTSStatusReporter reporter(decoderList, stageLatencies.histogram(stages::TOTAL), verbosity, std::chrono::seconds{interval});
+            for (std::size_t i{0}; i < clocks.size(); i++) {
+                reporter.watch(static_cast<uint32_t>(i), clocks[i].health());
+            }
+            reporter.watch(stageLatencies);
+            // Health of the units on the OD4 bus, sent from the main thread below.
+            OxTSHealthPublisher health(od4, decoderList, stamps, stageLatencies.histogram(stages::TOTAL), std::chrono::seconds{healthInterval});
+            // Time points of the packet just decoded; only used by the pipeline's thread.
+            stages::Marks marks;
+            // Packets released by a reorder window after waiting are not the one just decoded (isHeld).
+            auto publish = [&decoders, &forwarders, &clocks, &stageLatencies, &marks, &status=reporter](uint32_t unit, const OxTSDecoder::Readings &readings, const std::chrono::system_clock::time_point &tp, bool isHeld) noexcept {
+                // The receive time includes network and scheduling jitter; prefer the unit's GPS time.
+                std::chrono::system_clock::time_point sampleTp{tp};
+                if (readings.hasGpsTime) {
+                    ClockOffsetEstimator &clock = clocks[unit];
+                    // Late packets were delayed on the way and would only widen the residuals.
+                    if ( (OxTSDecoder::Sequence::DUPLICATE != readings.sequence) && (OxTSDecoder::Sequence::REORDERED != readings.sequence) ) {
+                        clock.add(readings.gpsTime, tp);
+                    }
+                    if (clock.isLocked()) {
+                        sampleTp = clock.toSystemClock(readings.gpsTime);
+                    }
+                }
+
+                const bool IS_SAMPLED{!isHeld && marks.isSampled};
+                if (forwarders[unit].forward(readings, decoders[unit].status(), cluon::time::convert(sampleTp), tp, IS_SAMPLED ? &marks : nullptr)) {
+                    if (IS_SAMPLED) {
+                        marks.sendEnd = stages::now();
+                    }
+                    stageLatencies.record(IS_SAMPLED ? marks : stages::Marks{}, std::chrono::system_clock::now() - tp);
+                }
+                if (0 != (readings.batches & OxTSDecoder::BATCH_B)) {
+                    status.update(unit, readings.position.latitude(), readings.position.longitude(), readings.heading.northHeading());
+                }
+            };
+            // Optionally, the packets of each unit are put back into order before publishing.
+            std::deque<OxTSReorderWindow> windows;
+            for (uint32_t i{0}; i < endpoints.size(); i++) {
+                windows.emplace_back(reorderDepth, PERIOD, [&publish, i](const OxTSDecoder::Readings &readings, const std::chrono::system_clock::time_point &tp, bool isHeld) noexcept {
+                    publish(i, readings, tp, isHeld);
+                });
+                reporter.watch(i, windows.back().statistics());
+            }
+            // Packets are decoded and published in the pipeline's thread.
+            OxTSPipeline pipeline(OVERFLOW_POLICY,
+                [&decoders, &windows, &publish, &stageLatencies, &marks](uint32_t unit, const uint8_t *data, std::size_t length, const std::chrono::system_clock::time_point &tp) noexcept {
+                stageLatencies.begin(marks);
+                OxTSDecoder::Readings readings;
+                const bool DECODED{decoders[unit].decode(data, length, readings)};
+                if (marks.isSampled) {
+                    marks.decodeEnd = stages::now();
+                }
+                if (DECODED) {
+                    windows[unit].push(readings, tp);
+                } else {
+                    // Rejected packets have nothing to order but keep the state messages going.
+                    publish(unit, readings, tp, false);
+                }
+                // Another unit may have stalled with packets held.
+                for (auto &window : windows) {
+                    window.expire(tp);
+                }
+            },
+                // Held packets of stalled units are released while the pipeline is idle.
+                [&windows]() noexcept {
+                const std::chrono::system_clock::time_point NOW{std::chrono::system_clock::now()};
+                for (auto &window : windows) {
+                    window.expire(NOW);
+                }
+            });
+            reporter.watch(pipeline.statistics());
+            health.watch(pipeline.statistics());
+
+            // One thread receives from all units and only queues packets.
+            OxTSReceiver fromOXTS(endpoints,
+                [&queue = pipeline, recorder = blackBox.get()](uint32_t unit, const uint8_t *data, std::size_t length, const std::chrono::system_clock::time_point &tp) noexcept {
+                if (nullptr != recorder) {
+                    recorder->record(unit, data, length, tp);
+                }
+                queue.push(unit, data, length, tp);
+            });
+            health.watch(fromOXTS);
+
+            std::signal(SIGUSR1, requestStages);
+
+            // Just sleep as this microservice is data driven; only the health is sent periodically.
+            using namespace std::literals::chrono_literals;
+            while (od4.isRunning()) {
+                std::this_thread::sleep_for(1s);
+                health.publish(std::chrono::steady_clock::now());
+                if (0 != stagesRequested) {
+                    stagesRequested = 0;
+                    const std::string STAGES{stageLatencies.summary()};
+                    std::cout << "[oxts] " << (STAGES.empty() ? (stages::ENABLED ? "no packets published yet" : "stage timing is compiled out") : STAGES) << std::endl;
                 }
             }
-        });
 
-        // Just sleep as this microservice is data driven.
-        using namespace std::literals::chrono_literals;
-        while (od4.isRunning()) {
-            std::this_thread::sleep_for(1s);
+            // The reporter watches the pipeline and the windows, which are destroyed first: Stop publishing,
+            // publish the packets still held by the windows, then stop reporting.
+            pipeline.stop();
+            for (auto &window : windows) {
+                window.flush();
+            }
+            reporter.stop();
         }
     }
     return retCode;
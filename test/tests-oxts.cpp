@@ -21,11 +21,62 @@
 #include "cluon-complete.hpp"
 #include "opendlv-standard-message-set.hpp"
 
+#include "oxts-black-box.hpp"
+#include "oxts-clock.hpp"
+#include "oxts-converter.hpp"
 #include "oxts-decoder.hpp"
+#include "oxts-forwarder.hpp"
+#include "oxts-framer.hpp"
+#include "oxts-health.hpp"
+#include "oxts-kernels.hpp"
+#include "oxts-latency.hpp"
+#include "oxts-legacy.hpp"
+#include "oxts-ncom.hpp"
+#include "oxts-pipeline.hpp"
+#include "oxts-publisher.hpp"
+#include "oxts-receiver.hpp"
+#include "oxts-recording.hpp"
+#include "oxts-reorder-window.hpp"
+#include "oxts-spsc-ring.hpp"
+#include "oxts-stages.hpp"
+#include "oxts-status-reporter.hpp"
 
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <vector>
 
+namespace {
+using legacy::SAMPLE;
+
+// Recomputes the three checksums of a modified packet.
+void updateChecksums(std::vector<uint8_t> &packet) {
+    uint8_t sum{0};
+    for (std::size_t i{ncom::Sync::OFFSET + ncom::Sync::WIDTH}; i < ncom::Checksum3::OFFSET; i++) {
+        if ( (ncom::Checksum1::OFFSET == i) || (ncom::Checksum2::OFFSET == i) ) {
+            packet[i] = sum;
+        }
+        sum = static_cast<uint8_t>(sum + packet[i]);
+    }
+    packet[ncom::Checksum3::OFFSET] = sum;
+}
+} // namespace
+
 TEST_CASE("Test OxTSDecoder with empty payload.") {
     const std::string DATA;
 
@@ -71,6 +122,1915 @@ TEST_CASE("Test OxTSDecoder with sample payload.") {
     REQUIRE(58.037722605 == Approx(msg1.latitude()));
     REQUIRE(12.796579564 == Approx(msg1.longitude()));
 
-    REQUIRE(2.1584727764 == Approx(msg2.northHeading()));
+    // The sample's heading 0xE0AEEB is negative; it was read unsigned as 2.1584727764 originally.
+    REQUIRE(-2.0523729324 == Approx(msg2.northHeading()));
+}
+
+
+TEST_CASE("Test OxTSDecoder with sample payload from raw buffer.") {
+    std::array<uint8_t, 72> packet;
+    std::copy(SAMPLE.begin(), SAMPLE.end(), packet.begin());
+
+    OxTSDecoder d;
+    auto retVal = d.decode(packet.data(), packet.size());
+    REQUIRE(retVal.first);
+
+    REQUIRE(!d.decode(nullptr, 72).first);
+    REQUIRE(!d.decode(packet.data(), 71).first);
+}
+
+TEST_CASE("Test OxTSDecoder raw buffer decoding matches the stream-based decoder bit for bit.") {
+    // Positions on both hemispheres and non-negative headings with and without normalizing; negative
+    // headings were read unsigned by the original decoder and are compared separately below.
+    const std::vector<std::array<double, 2>> POSITIONS{{{1.0129371, 0.2233399}}, {{-0.5, -3.1}}, {{0.0, 1e-9}}, {{1.5707963, -0.0}}};
+    const std::vector<uint32_t> HEADINGS{0x000000, 0x000001, 0x2FEE6A, 0x2FEE6B, 0x4C4B40, 0x5FDCD5, 0x6ACFBF, 0x7FFFFF};
+
+    OxTSDecoder d;
+    std::size_t compared{0};
+    for (const auto &position : POSITIONS) {
+        for (uint32_t heading : HEADINGS) {
+            std::vector<uint8_t> packet{SAMPLE};
+            std::memcpy(&packet[ncom::Latitude::OFFSET], &position[0], sizeof(double));
+            std::memcpy(&packet[ncom::Longitude::OFFSET], &position[1], sizeof(double));
+            const uint32_t HEADING{htole32(heading)};
+            std::memcpy(&packet[ncom::Heading::OFFSET], &HEADING, ncom::Heading::WIDTH);
+            updateChecksums(packet);
+
+            const legacy::Readings EXPECTED{legacy::decode(std::string(reinterpret_cast<const char*>(packet.data()), packet.size()))};
+            auto retVal = d.decode(packet.data(), packet.size());
+            REQUIRE(retVal.first);
+            REQUIRE(EXPECTED.latitude == retVal.second.first.latitude());
+            REQUIRE(EXPECTED.longitude == retVal.second.first.longitude());
+            REQUIRE(EXPECTED.northHeading == retVal.second.second.northHeading());
+            compared++;
+        }
+    }
+    REQUIRE(POSITIONS.size() * HEADINGS.size() == compared);
+
+    // Negative headings are read signed like pitch and roll: -1 rad was decoded as about -3.07 rad originally.
+    std::vector<uint8_t> negative{SAMPLE};
+    const uint32_t MINUS_ONE_RAD{htole32(static_cast<uint32_t>(-1000000) & 0xFFFFFFu)};
+    std::memcpy(&negative[ncom::Heading::OFFSET], &MINUS_ONE_RAD, ncom::Heading::WIDTH);
+    updateChecksums(negative);
+    REQUIRE(-3.0723410f == Approx(legacy::decode(std::string(reinterpret_cast<const char*>(negative.data()), negative.size())).northHeading));
+    auto negativeRetVal = d.decode(negative.data(), negative.size());
+    REQUIRE(negativeRetVal.first);
+    REQUIRE(-1.0f == Approx(negativeRetVal.second.second.northHeading()));
+
+    // Unchanged sample as decoded by the original decoder, apart from its negative heading.
+    auto retVal = d.decode(SAMPLE.data(), SAMPLE.size());
+    REQUIRE(retVal.first);
+    REQUIRE(58.037722605 == Approx(retVal.second.first.latitude()));
+    REQUIRE(12.796579564 == Approx(retVal.second.first.longitude()));
+    REQUIRE(2.1584727764 == Approx(legacy::decode(std::string(reinterpret_cast<const char*>(SAMPLE.data()), SAMPLE.size())).northHeading));
+    REQUIRE(-2.0523729324 == Approx(retVal.second.second.northHeading()));
+}
+
+TEST_CASE("Test OxTSDecoder decoding all channels from sample payload.") {
+    OxTSDecoder d;
+    OxTSDecoder::Readings readings;
+    REQUIRE(d.decode(SAMPLE.data(), SAMPLE.size(), readings));
+
+    REQUIRE(58.037722605 == Approx(readings.position.latitude()));
+    REQUIRE(12.796579564 == Approx(readings.position.longitude()));
+    REQUIRE(-2.0523729324 == Approx(readings.heading.northHeading()));
+
+    REQUIRE(0.2197f == Approx(readings.acceleration.accelerationX()));
+    REQUIRE(0.3708f == Approx(readings.acceleration.accelerationY()));
+    REQUIRE(-9.8042f == Approx(readings.acceleration.accelerationZ()));
+
+    REQUIRE(0.00069f == Approx(readings.angularVelocity.angularVelocityX()));
+    REQUIRE(0.00244f == Approx(readings.angularVelocity.angularVelocityY()));
+    REQUIRE(-0.00086f == Approx(readings.angularVelocity.angularVelocityZ()));
+
+    REQUIRE(104.17605f == Approx(readings.altitude.altitude()));
+
+    REQUIRE(0.005f == Approx(readings.equilibrioception.vx()));
+    REQUIRE(0.0005f == Approx(readings.equilibrioception.vy()));
+    REQUIRE(0.0044f == Approx(readings.equilibrioception.vz()));
+    REQUIRE(readings.angularVelocity.angularVelocityZ() == Approx(readings.equilibrioception.yawRate()));
+
+    REQUIRE(0.022784f == Approx(readings.pitch));
+    REQUIRE(-0.037954f == Approx(readings.roll));
+
+    // Readings remain untouched for undecodable packets.
+    REQUIRE(!d.decode(SAMPLE.data(), SAMPLE.size() - 1, readings));
+    REQUIRE(58.037722605 == Approx(readings.position.latitude()));
+}
+
+TEST_CASE("Test NCOM field extraction.") {
+    std::array<uint8_t, ncom::PACKET_LENGTH> packet;
+    packet.fill(0);
+
+    // Most negative and most positive 24 bit values.
+    packet[ncom::AccelerationX::OFFSET + 2] = 0x80;
+    packet[ncom::AccelerationY::OFFSET + 0] = 0xFF;
+    packet[ncom::AccelerationY::OFFSET + 1] = 0xFF;
+    packet[ncom::AccelerationY::OFFSET + 2] = 0x7F;
+    REQUIRE(-8388608 == ncom::raw<ncom::AccelerationX>(packet.data()));
+    REQUIRE(8388607 == ncom::raw<ncom::AccelerationY>(packet.data()));
+    REQUIRE(-838.8608f == Approx(ncom::value<ncom::AccelerationX>(packet.data())));
+
+    // Heading is sign-extended like pitch and roll.
+    packet[ncom::Heading::OFFSET + 2] = 0xFF;
+    REQUIRE(-65536 == ncom::raw<ncom::Heading>(packet.data()));
+
+    REQUIRE(38300 == ncom::raw<ncom::Time>(SAMPLE.data()));
+    REQUIRE(4 == ncom::raw<ncom::NavigationStatus>(SAMPLE.data()));
+    REQUIRE(1e-6f == ncom::Pitch::scale());
+}
+
+TEST_CASE("Test OxTSDecoder checksum validation.") {
+    OxTSDecoder d;
+    OxTSDecoder::Readings readings;
+
+    REQUIRE(d.decode(SAMPLE.data(), SAMPLE.size(), readings));
+    REQUIRE((OxTSDecoder::BATCH_A | OxTSDecoder::BATCH_B | OxTSDecoder::BATCH_S) == readings.batches);
+
+    // Corrupted status channel: position is still available.
+    std::vector<uint8_t> corrupted{SAMPLE};
+    corrupted[65] ^= 0x10;
+    REQUIRE(d.decode(corrupted.data(), corrupted.size(), readings));
+    REQUIRE((OxTSDecoder::BATCH_A | OxTSDecoder::BATCH_B) == readings.batches);
+    REQUIRE(d.decode(corrupted.data(), corrupted.size()).first);
+
+    // Corrupted latitude: only batch A is available.
+    corrupted = SAMPLE;
+    corrupted[25] ^= 0x01;
+    REQUIRE(d.decode(corrupted.data(), corrupted.size(), readings));
+    REQUIRE(OxTSDecoder::BATCH_A == readings.batches);
+    REQUIRE(!d.decode(corrupted.data(), corrupted.size()).first);
+
+    // Corrupted checksum 1 while the later checksums match: batch A is covered by checksum 2.
+    corrupted = SAMPLE;
+    corrupted[22] = static_cast<uint8_t>(corrupted[22] + 1);
+    corrupted[61] = static_cast<uint8_t>(corrupted[61] + 1);
+    corrupted[71] = static_cast<uint8_t>(corrupted[71] + 2);
+    REQUIRE(d.decode(corrupted.data(), corrupted.size(), readings));
+    REQUIRE((OxTSDecoder::BATCH_A | OxTSDecoder::BATCH_B | OxTSDecoder::BATCH_S) == readings.batches);
+
+    // Wrong sync byte.
+    corrupted = SAMPLE;
+    corrupted[0] = 0xE6;
+    REQUIRE(!d.decode(corrupted.data(), corrupted.size(), readings));
+    REQUIRE(!d.decode(SAMPLE.data(), 10, readings));
+
+    const OxTSDecoder::Statistics &statistics = d.statistics();
+    REQUIRE(8 == statistics.packets.load());
+    REQUIRE(1 == statistics.invalidLength.load());
+    REQUIRE(1 == statistics.invalidSync.load());
+    REQUIRE(1 == statistics.invalidChecksum1.load());
+    REQUIRE(2 == statistics.invalidChecksum2.load());
+    REQUIRE(4 == statistics.invalidChecksum3.load());
+    REQUIRE(2 == statistics.rejected.load());
+}
+
+TEST_CASE("Test OxTSDecoder batch decoding.") {
+    constexpr std::size_t COUNT{5};
+    std::vector<uint8_t> packets;
+    for (std::size_t i{0}; i < COUNT; i++) {
+        packets.insert(packets.end(), SAMPLE.begin(), SAMPLE.end());
+    }
+    // Corrupt the position of the second and the sync byte of the fourth packet.
+    packets[1 * ncom::PACKET_LENGTH + 30] ^= 0x01;
+    packets[3 * ncom::PACKET_LENGTH] = 0x00;
+
+    std::vector<double> latitude(COUNT);
+    std::vector<double> longitude(COUNT);
+    std::vector<float> northHeading(COUNT);
+    std::vector<uint8_t> valid(COUNT);
+    OxTSDecoder::Columns columns;
+    columns.latitude = latitude.data();
+    columns.longitude = longitude.data();
+    columns.northHeading = northHeading.data();
+    columns.valid = valid.data();
+
+    OxTSDecoder d;
+    REQUIRE(3 == d.decodeBatch(packets.data(), COUNT, columns));
+    REQUIRE(std::vector<uint8_t>{1, 0, 1, 0, 1} == valid);
+
+    auto reference = d.decode(SAMPLE.data(), SAMPLE.size());
+    for (std::size_t i : {0, 2, 4}) {
+        REQUIRE(reference.second.first.latitude() == Approx(latitude[i]));
+        REQUIRE(reference.second.first.longitude() == Approx(longitude[i]));
+        REQUIRE(reference.second.second.northHeading() == Approx(northHeading[i]));
+    }
+    REQUIRE(0.0 == Approx(latitude[1]));
+
+    REQUIRE(6 == d.statistics().packets.load());
+    REQUIRE(1 == d.statistics().invalidSync.load());
+    REQUIRE(1 == d.statistics().invalidChecksum2.load());
+    REQUIRE(1 == d.statistics().rejected.load());
+
+    // Columns may be omitted.
+    REQUIRE(3 == d.decodeBatch(packets.data(), COUNT, OxTSDecoder::Columns{}));
+}
+
+TEST_CASE("Test angle normalization matches the original loops over the whole 24 bit range.") {
+    std::size_t mismatches{0};
+    for (uint32_t v{0}; v < (1u << 24); v++) {
+        // Unsigned interpretation as heading was read originally.
+        const float HEADING{static_cast<float>(v) * 1e-6f};
+        const float EXPECTED_HEADING{legacy::normalizeAngle(HEADING)};
+        const float ACTUAL_HEADING{ncom::normalizeAngle(HEADING)};
+        mismatches += (0 == std::memcmp(&EXPECTED_HEADING, &ACTUAL_HEADING, sizeof(float))) ? 0 : 1;
+
+        // Signed interpretation as used for heading, pitch, and roll.
+        const float ANGLE{static_cast<float>(static_cast<int32_t>(v ^ 0x800000u) - 0x800000) * 1e-6f};
+        const float EXPECTED_ANGLE{legacy::normalizeAngle(ANGLE)};
+        const float ACTUAL_ANGLE{ncom::normalizeAngle(ANGLE)};
+        mismatches += (0 == std::memcmp(&EXPECTED_ANGLE, &ACTUAL_ANGLE, sizeof(float))) ? 0 : 1;
+    }
+    REQUIRE(0 == mismatches);
+
+    REQUIRE(0.0f == Approx(ncom::normalizeAngle(static_cast<float>(4.0 * M_PI))).margin(1e-5));
+    REQUIRE(-3.0f == Approx(ncom::normalizeAngle(static_cast<float>(-3.0 + 6.0 * M_PI))));
+    REQUIRE(static_cast<float>(M_PI) / 2.0f == ncom::normalizeAngle(static_cast<float>(M_PI) / 2.0f));
+}
+
+TEST_CASE("Test 24 bit kernels are bit-exact to scalar decoding over the whole 24 bit range.") {
+    constexpr std::size_t COUNT{4096};
+    std::vector<uint8_t> packets(COUNT * ncom::PACKET_LENGTH, 0);
+    std::vector<float> expected(COUNT);
+    std::vector<float> actual(COUNT);
+
+    const std::array<ncom::Channel24, 3> CHANNELS{{
+        ncom::channel24<ncom::Heading>(true),
+        ncom::channel24<ncom::Pitch>(true),
+        ncom::channel24<ncom::AccelerationX>(),
+    }};
+
+    std::size_t mismatches{0};
+    for (uint32_t first{0}; first < (1u << 24); first += COUNT) {
+        for (std::size_t i{0}; i < COUNT; i++) {
+            const uint32_t v{first + static_cast<uint32_t>(i)};
+            for (const auto &channel : CHANNELS) {
+                uint8_t *p{packets.data() + i * ncom::PACKET_LENGTH + channel.offset};
+                p[0] = static_cast<uint8_t>(v);
+                p[1] = static_cast<uint8_t>(v >> 8);
+                p[2] = static_cast<uint8_t>(v >> 16);
+            }
+        }
+        for (const auto &channel : CHANNELS) {
+            for (std::size_t i{0}; i < COUNT; i++) {
+                const uint8_t *p{packets.data() + i * ncom::PACKET_LENGTH};
+                if (ncom::Heading::OFFSET == channel.offset) {
+                    expected[i] = ncom::normalizeAngle(ncom::value<ncom::Heading>(p));
+                } else if (ncom::Pitch::OFFSET == channel.offset) {
+                    expected[i] = ncom::normalizeAngle(ncom::value<ncom::Pitch>(p));
+                } else {
+                    expected[i] = ncom::value<ncom::AccelerationX>(p);
+                }
+            }
+            for (auto kernel : {ncom::Kernel::SCALAR, ncom::Kernel::SSE2, ncom::Kernel::AVX2}) {
+                if (ncom::isSupported(kernel)) {
+                    ncom::extract24(kernel, packets.data(), COUNT, channel, actual.data());
+                    mismatches += (0 == std::memcmp(expected.data(), actual.data(), COUNT * sizeof(float))) ? 0 : 1;
+                }
+            }
+        }
+    }
+    REQUIRE(ncom::isSupported(ncom::bestKernel()));
+    REQUIRE(0 == mismatches);
+}
+
+TEST_CASE("Test OxTSDecoder batch decoding of all 24 bit channels.") {
+    constexpr std::size_t COUNT{19};
+    std::vector<uint8_t> packets;
+    for (std::size_t i{0}; i < COUNT; i++) {
+        packets.insert(packets.end(), SAMPLE.begin(), SAMPLE.end());
+    }
+    packets[7 * ncom::PACKET_LENGTH + 50] ^= 0x01;
+
+    std::array<std::vector<float>, 13> columns;
+    for (auto &c : columns) {
+        c.resize(COUNT);
+    }
+    OxTSDecoder::Columns c;
+    c.northHeading = columns[0].data();
+    c.accelerationX = columns[1].data();
+    c.accelerationY = columns[2].data();
+    c.accelerationZ = columns[3].data();
+    c.angularVelocityX = columns[4].data();
+    c.angularVelocityY = columns[5].data();
+    c.angularVelocityZ = columns[6].data();
+    c.velocityNorth = columns[7].data();
+    c.velocityEast = columns[8].data();
+    c.velocityDown = columns[9].data();
+    c.pitch = columns[10].data();
+    c.roll = columns[11].data();
+    c.altitude = columns[12].data();
+
+    OxTSDecoder d;
+    REQUIRE(COUNT - 1 == d.decodeBatch(packets.data(), COUNT, c));
+
+    OxTSDecoder::Readings r;
+    REQUIRE(d.decode(SAMPLE.data(), SAMPLE.size(), r));
+    const std::array<float, 13> EXPECTED{{r.heading.northHeading(), r.acceleration.accelerationX(), r.acceleration.accelerationY(),
+                                          r.acceleration.accelerationZ(), r.angularVelocity.angularVelocityX(),
+                                          r.angularVelocity.angularVelocityY(), r.angularVelocity.angularVelocityZ(),
+                                          r.equilibrioception.vx(), r.equilibrioception.vy(), r.equilibrioception.vz(), r.pitch, r.roll,
+                                          r.altitude.altitude()}};
+    for (std::size_t j{0}; j < columns.size(); j++) {
+        for (std::size_t i{0}; i < COUNT; i++) {
+            const float value{(7 == i) ? 0.0f : EXPECTED[j]};
+            REQUIRE(0 == std::memcmp(&value, &columns[j][i], sizeof(float)));
+        }
+    }
+}
+
+TEST_CASE("Test OxTSReceiver receives datagrams in place.") {
+    std::mutex lengthsMutex;
+    std::vector<std::size_t> lengths;
+    uint32_t validPackets{0};
+    OxTSDecoder d;
+    OxTSReceiver receiver("127.0.0.1", 31972,
+        [&lengthsMutex, &lengths, &validPackets, &d](const uint8_t *data, std::size_t length, const std::chrono::system_clock::time_point &tp) noexcept {
+        std::lock_guard<std::mutex> lck(lengthsMutex);
+        lengths.push_back(length);
+        validPackets += (d.decode(data, length).first && (0 < cluon::time::convert(tp).seconds()) ? 1 : 0);
+    });
+    REQUIRE(receiver.isRunning());
+
+    cluon::UDPSender sender("127.0.0.1", 31972);
+    sender.send(std::string(reinterpret_cast<const char*>(SAMPLE.data()), SAMPLE.size()));
+    sender.send(std::string(100, '\xE7'));
+
+    using namespace std::literals::chrono_literals;
+    for (uint32_t i{0}; i < 100; i++) {
+        {
+            std::lock_guard<std::mutex> lck(lengthsMutex);
+            if (2 == lengths.size()) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(10ms);
+    }
+
+    std::lock_guard<std::mutex> lck(lengthsMutex);
+    REQUIRE(2 == lengths.size());
+    REQUIRE(ncom::PACKET_LENGTH == lengths[0]);
+    // Oversized datagrams are truncated but still recognized as invalid.
+    REQUIRE(ncom::PACKET_LENGTH + 1 == lengths[1]);
+    REQUIRE(1 == validPackets);
+    REQUIRE(1 == d.statistics().invalidLength.load());
+}
+
+TEST_CASE("Test LatencyHistogram buckets and percentiles.") {
+    // Buckets are contiguous and at most 1/16 of their lower bound wide.
+    uint64_t lower{0};
+    for (std::size_t b{0}; b + 1 < LatencyHistogram::BUCKETS; b++) {
+        const uint64_t UPPER{LatencyHistogram::upperBoundOf(b)};
+        REQUIRE(b == LatencyHistogram::bucketOf(lower));
+        REQUIRE(b == LatencyHistogram::bucketOf(UPPER));
+        REQUIRE((UPPER - lower) * 16 <= lower + 15);
+        lower = UPPER + 1;
+    }
+    REQUIRE(LatencyHistogram::BUCKETS - 1 == LatencyHistogram::bucketOf(UINT64_MAX));
+
+    LatencyHistogram h;
+    REQUIRE(0 == h.count());
+    REQUIRE(0 == h.percentile(50.0).count());
+    for (int64_t i{1}; i <= 1000; i++) {
+        h.record(std::chrono::microseconds{i});
+    }
+    h.record(std::chrono::nanoseconds{-5});
+    REQUIRE(1001 == h.count());
+    REQUIRE(1000000 == h.max().count());
+    REQUIRE(500000.0 == Approx(static_cast<double>(h.percentile(50.0).count())).epsilon(0.07));
+    REQUIRE(990000.0 == Approx(static_cast<double>(h.percentile(99.0).count())).epsilon(0.07));
+    REQUIRE(1000000 == h.percentile(100.0).count());
+    REQUIRE(0 == h.percentile(0.0).count());
+
+    h.reset();
+    REQUIRE(0 == h.count());
+}
+
+TEST_CASE("Test OxTSStatusReporter summarizes decoder activity.") {
+    OxTSDecoder d;
+    LatencyHistogram latency;
+    for (uint32_t i{0}; i < 10; i++) {
+        d.decode(SAMPLE.data(), SAMPLE.size());
+    }
+    d.decode(SAMPLE.data(), SAMPLE.size() - 1);
+    latency.record(std::chrono::microseconds{42});
+
+    std::stringstream quietOutput;
+    {
+        OxTSStatusReporter quiet(d, latency, OxTSStatusReporter::QUIET, std::chrono::milliseconds{1}, quietOutput);
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    }
+    REQUIRE(quietOutput.str().empty());
+
+    std::stringstream output;
+    {
+        OxTSStatusReporter reporter(d, latency, OxTSStatusReporter::DETAILED, std::chrono::hours{1}, output);
+        std::string s{reporter.summary(std::chrono::seconds{2})};
+        REQUIRE(std::string::npos != s.find("5.5 packets/s, 11 packets, 1 rejected, 0 checksum errors (length: 1"));
+        REQUIRE(std::string::npos != s.find("no fix"));
+        REQUIRE(std::string::npos != s.find("latency p50/p99/p99.9/max = 42/42/42/42 us"));
+
+        reporter.update(57.7, 11.9, 2.0f);
+        s = reporter.summary(std::chrono::seconds{1});
+        REQUIRE(std::string::npos != s.find("0.0 packets/s"));
+        REQUIRE(std::string::npos != s.find("latitude = 57.7"));
+    }
+    // The reporting thread is stopped without waiting for the interval.
+    REQUIRE(output.str().empty());
+
+    std::stringstream periodicOutput;
+    {
+        OxTSStatusReporter reporter(d, latency, OxTSStatusReporter::SUMMARY, std::chrono::milliseconds{5}, periodicOutput);
+        std::this_thread::sleep_for(std::chrono::milliseconds{50});
+
+        // Nothing is reported once stopped, so that watched objects can be destroyed before the reporter.
+        reporter.stop();
+        const std::size_t LENGTH{periodicOutput.str().size()};
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        REQUIRE(LENGTH == periodicOutput.str().size());
+        reporter.stop();
+    }
+    REQUIRE(std::string::npos != periodicOutput.str().find("[oxts] "));
+    REQUIRE(std::string::npos == periodicOutput.str().find("length:"));
+}
+
+namespace {
+template <typename T>
+std::string od4SessionEncoding(T &message, const cluon::data::TimeStamp &sampleTimeStamp, const cluon::data::TimeStamp &sent, uint32_t senderStamp) {
+    // Same steps as cluon::OD4Session::send() but with a given sent time stamp.
+    cluon::ToProtoVisitor protoEncoder;
+    cluon::data::Envelope envelope;
+    envelope.dataType(static_cast<int32_t>(message.ID()));
+    message.accept(protoEncoder);
+    envelope.serializedData(protoEncoder.encodedData());
+    envelope.sent(sent);
+    envelope.sampleTimeStamp((0 == (sampleTimeStamp.seconds() + sampleTimeStamp.microseconds())) ? envelope.sent() : sampleTimeStamp);
+    envelope.senderStamp(senderStamp);
+    return cluon::OD4Session::serializeAsOD4Container(std::move(envelope));
+}
+
+template <typename T>
+bool encodesLikeOD4Session(od4::Publisher &publisher, T &message, const cluon::data::TimeStamp &sampleTimeStamp, const cluon::data::TimeStamp &sent, uint32_t senderStamp) {
+    const auto FRAME = publisher.serialize(message, sampleTimeStamp, sent, senderStamp);
+    return od4SessionEncoding(message, sampleTimeStamp, sent, senderStamp)
+           == std::string(reinterpret_cast<const char*>(FRAME.first), FRAME.second);
+}
+} // namespace
+
+TEST_CASE("Test od4::Publisher encodes identically to OD4Session.") {
+    od4::Publisher publisher{111};
+    OxTSDecoder d;
+    OxTSDecoder::Readings r;
+    REQUIRE(d.decode(SAMPLE.data(), SAMPLE.size(), r));
+
+    cluon::data::TimeStamp sent;
+    sent.seconds(1528798712).microseconds(123456);
+    std::vector<cluon::data::TimeStamp> samples(4);
+    samples[1].seconds(1).microseconds(0);
+    samples[2].seconds(-5).microseconds(999999);
+    samples[3].seconds(INT32_MAX).microseconds(INT32_MIN);
+
+    opendlv::proxy::GeodeticWgs84Reading extreme;
+    extreme.latitude(-90.0).longitude(std::nan(""));
+    // Varints of different lengths.
+    opendlv::body::SensorInfo info;
+    info.description("position").signalId(opendlv::proxy::GeodeticWgs84Reading::ID()).accuracyStd(0.25f);
+    opendlv::body::SensorInfo largeInfo;
+    largeInfo.description(std::string(od4::Payload<opendlv::body::SensorInfo>::DESCRIPTION_CAPACITY, 'x')).x(1.0f).y(-2.0f).z(3.0f)
+             .signalId(UINT32_MAX).accuracyStd(100.0f).minFrequency(UINT16_MAX);
+    for (const auto &sample : samples) {
+        for (uint32_t senderStamp : {0u, 1u, 300u, UINT32_MAX}) {
+            REQUIRE(encodesLikeOD4Session(publisher, r.position, sample, sent, senderStamp));
+            REQUIRE(encodesLikeOD4Session(publisher, extreme, sample, sent, senderStamp));
+            REQUIRE(encodesLikeOD4Session(publisher, r.heading, sample, sent, senderStamp));
+            REQUIRE(encodesLikeOD4Session(publisher, r.altitude, sample, sent, senderStamp));
+            REQUIRE(encodesLikeOD4Session(publisher, r.acceleration, sample, sent, senderStamp));
+            REQUIRE(encodesLikeOD4Session(publisher, r.angularVelocity, sample, sent, senderStamp));
+            REQUIRE(encodesLikeOD4Session(publisher, r.equilibrioception, sample, sent, senderStamp));
+            REQUIRE(encodesLikeOD4Session(publisher, info, sample, sent, senderStamp));
+            REQUIRE(encodesLikeOD4Session(publisher, largeInfo, sample, sent, senderStamp));
+        }
+    }
+    // Payloads of varying length share a frame.
+    opendlv::body::SensorInfo emptyInfo;
+    REQUIRE(encodesLikeOD4Session(publisher, emptyInfo, samples[0], sent, 0));
+    REQUIRE(encodesLikeOD4Session(publisher, largeInfo, samples[3], sent, UINT32_MAX));
+    REQUIRE(encodesLikeOD4Session(publisher, info, samples[1], sent, 1));
+
+    // Longer descriptions are truncated.
+    largeInfo.description(largeInfo.description() + "y");
+    const auto TRUNCATED = publisher.serialize(largeInfo, samples[1], sent, 1);
+    largeInfo.description(std::string(od4::Payload<opendlv::body::SensorInfo>::DESCRIPTION_CAPACITY, 'x'));
+    REQUIRE(od4SessionEncoding(largeInfo, samples[1], sent, 1) == std::string(reinterpret_cast<const char*>(TRUNCATED.first), TRUNCATED.second));
+
+    // Frames are reused: A later message must not carry over previous bytes.
+    REQUIRE(encodesLikeOD4Session(publisher, r.position, samples[3], sent, UINT32_MAX));
+    REQUIRE(encodesLikeOD4Session(publisher, r.position, samples[0], cluon::data::TimeStamp{}, 0));
+
+    // The encoding can be decoded by OD4Session's receiving side.
+    const auto FRAME = publisher.serialize(r.position, samples[1], sent, 7);
+    cluon::data::Envelope env;
+    {
+        std::stringstream sstr{std::string(reinterpret_cast<const char*>(FRAME.first) + 5, FRAME.second - 5)};
+        cluon::FromProtoVisitor protoDecoder;
+        protoDecoder.decodeFrom(sstr);
+        env.accept(protoDecoder);
+    }
+    REQUIRE(opendlv::proxy::GeodeticWgs84Reading::ID() == env.dataType());
+    REQUIRE(7 == env.senderStamp());
+    REQUIRE(1 == env.sampleTimeStamp().seconds());
+    auto position = cluon::extractMessage<opendlv::proxy::GeodeticWgs84Reading>(std::move(env));
+    REQUIRE(r.position.latitude() == Approx(position.latitude()));
+    REQUIRE(r.position.longitude() == Approx(position.longitude()));
+}
+
+TEST_CASE("Test od4::Publisher sends queued messages upon flush.") {
+    std::mutex stampsMutex;
+    std::vector<uint32_t> stamps;
+    cluon::OD4Session od4{252, [&stampsMutex, &stamps](cluon::data::Envelope &&envelope) {
+        if (static_cast<int32_t>(opendlv::proxy::GeodeticWgs84Reading::ID()) == envelope.dataType()) {
+            std::lock_guard<std::mutex> lck(stampsMutex);
+            stamps.push_back(envelope.senderStamp());
+        }
+    }};
+    REQUIRE(od4.isRunning());
+
+    od4::Publisher publisher{252};
+    OxTSDecoder d;
+    OxTSDecoder::Readings r;
+    REQUIRE(d.decode(SAMPLE.data(), SAMPLE.size(), r));
+    // More messages than fit into the queue flush it in between.
+    for (uint32_t i{0}; i < 20; i++) {
+        publisher.queue(r.position, cluon::data::TimeStamp{}, i);
+    }
+    publisher.flush();
+
+    using namespace std::literals::chrono_literals;
+    for (uint32_t i{0}; i < 100; i++) {
+        {
+            std::lock_guard<std::mutex> lck(stampsMutex);
+            if (20 <= stamps.size()) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(10ms);
+    }
+    std::lock_guard<std::mutex> lck(stampsMutex);
+    REQUIRE(20 == stamps.size());
+    for (uint32_t i{0}; i < 20; i++) {
+        REQUIRE(i == stamps[i]);
+    }
+}
+
+TEST_CASE("Test stages::Latencies breaks the total latency down by stage.") {
+    stages::Latencies latencies;
+    REQUIRE(latencies.summary().empty());
+
+    using namespace std::literals::chrono_literals;
+    stages::Marks marks;
+    REQUIRE(stages::ENABLED == latencies.begin(marks));
+    std::this_thread::sleep_for(2ms);
+    marks.decodeEnd    = stages::now();
+    marks.serializeEnd = stages::now();
+    std::this_thread::sleep_for(1ms);
+    marks.sendEnd = stages::now();
+    latencies.record(marks, 20ms);
+
+    if (stages::ENABLED) {
+        const std::chrono::nanoseconds DECODE{latencies.histogram(stages::DECODE).max()};
+        const std::chrono::nanoseconds SEND{latencies.histogram(stages::SEND).max()};
+        REQUIRE(1 == latencies.histogram(stages::TOTAL).count());
+        REQUIRE(DECODE >= 1800us);
+        REQUIRE(DECODE < 15ms);
+        REQUIRE(SEND >= 900us);
+        REQUIRE(latencies.histogram(stages::SERIALIZE).max() < 1ms);
+        // The remainder is attributed to waiting for the pipeline.
+        REQUIRE(latencies.histogram(stages::RECEIVE).max() <= 20ms - DECODE - SEND);
+        REQUIRE(latencies.histogram(stages::TOTAL).max() == 20ms);
+        REQUIRE(std::string::npos != latencies.summary().find("decode "));
+
+        OxTSDecoder d;
+        LatencyHistogram latency;
+        std::stringstream out;
+        OxTSStatusReporter detailed(d, latency, OxTSStatusReporter::DETAILED, std::chrono::milliseconds{0}, out);
+        detailed.watch(latencies);
+        REQUIRE(std::string::npos != detailed.summary(1s).find("\n[oxts] stages p50/p99/p99.9/max = receive "));
+        OxTSStatusReporter brief(d, latency, OxTSStatusReporter::SUMMARY, std::chrono::milliseconds{0}, out);
+        brief.watch(latencies);
+        REQUIRE(std::string::npos == brief.summary(1s).find("stages"));
+
+        // Only one in SAMPLING packets is broken down by stage.
+        uint32_t sampled{1};
+        for (uint32_t i{1}; i < 2 * stages::SAMPLING; i++) {
+            if (latencies.begin(marks)) {
+                marks.decodeEnd    = stages::now();
+                marks.serializeEnd = stages::now();
+                marks.sendEnd      = stages::now();
+                sampled++;
+            }
+            latencies.record(marks, 20ms);
+        }
+        REQUIRE(2 == sampled);
+        REQUIRE(2 == latencies.histogram(stages::DECODE).count());
+        REQUIRE(2 == latencies.histogram(stages::RECEIVE).count());
+        REQUIRE(2 * stages::SAMPLING == latencies.histogram(stages::TOTAL).count());
+    } else {
+        REQUIRE(!marks.isSampled);
+        REQUIRE(0 == marks.decodeStart);
+        REQUIRE(0 == latencies.histogram(stages::DECODE).count());
+        REQUIRE(1 == latencies.histogram(stages::TOTAL).count());
+        REQUIRE(latencies.summary().empty());
+    }
+}
+
+TEST_CASE("Test OxTSReceiver receives from several units with one thread.") {
+    std::mutex unitsMutex;
+    std::vector<uint32_t> units;
+    OxTSReceiver receiver(std::vector<OxTSReceiver::Endpoint>{{"127.0.0.1", 31973}, {"127.0.0.1", 31974}, {"127.0.0.1", 31975}},
+        [&unitsMutex, &units](uint32_t unit, const uint8_t *, std::size_t length, const std::chrono::system_clock::time_point &) noexcept {
+        std::lock_guard<std::mutex> lck(unitsMutex);
+        units.push_back((ncom::PACKET_LENGTH == length) ? unit : UINT32_MAX);
+    });
+    REQUIRE(receiver.isRunning());
+
+    const std::string DATA(reinterpret_cast<const char*>(SAMPLE.data()), SAMPLE.size());
+    cluon::UDPSender sender2("127.0.0.1", 31975);
+    cluon::UDPSender sender0("127.0.0.1", 31973);
+    sender2.send(std::string(DATA));
+    sender0.send(std::string(DATA));
+    sender2.send(std::string(DATA));
+
+    using namespace std::literals::chrono_literals;
+    for (uint32_t i{0}; i < 100; i++) {
+        {
+            std::lock_guard<std::mutex> lck(unitsMutex);
+            if (3 == units.size()) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(10ms);
+    }
+
+    std::lock_guard<std::mutex> lck(unitsMutex);
+    REQUIRE(3 == units.size());
+    std::sort(units.begin(), units.end());
+    REQUIRE(0 == units[0]);
+    REQUIRE(2 == units[1]);
+    REQUIRE(2 == units[2]);
+
+    // All endpoints must be valid.
+    OxTSReceiver invalid(std::vector<OxTSReceiver::Endpoint>{{"127.0.0.1", 31976}, {"localhost", 31977}}, nullptr);
+    REQUIRE(!invalid.isRunning());
+    OxTSReceiver none(std::vector<OxTSReceiver::Endpoint>{}, nullptr);
+    REQUIRE(!none.isRunning());
+}
+
+TEST_CASE("Test OxTSReceiver counts the datagrams dropped by the kernel.") {
+    std::mutex releaseMutex;
+    std::condition_variable releaseCondition;
+    bool isReleased{false};
+    std::atomic<uint32_t> received{0};
+    OxTSReceiver receiver(std::vector<OxTSReceiver::Endpoint>{{"127.0.0.1", 31976}},
+        [&releaseMutex, &releaseCondition, &isReleased, &received](uint32_t, const uint8_t *, std::size_t, const std::chrono::system_clock::time_point &) noexcept {
+        // Hold the receiving thread until the socket's buffer overflowed.
+        std::unique_lock<std::mutex> lck(releaseMutex);
+        releaseCondition.wait(lck, [&isReleased]() { return isReleased; });
+        received++;
+    });
+    REQUIRE(receiver.isRunning());
+    REQUIRE(0 == receiver.kernelDrops(0));
+    REQUIRE(0 == receiver.kernelDrops(1));
+
+    cluon::UDPSender sender("127.0.0.1", 31976);
+    const std::string PACKET(reinterpret_cast<const char*>(SAMPLE.data()), SAMPLE.size());
+    constexpr uint32_t SENT{20000};
+    for (uint32_t i{0}; i < SENT; i++) {
+        sender.send(std::string(PACKET));
+    }
+    {
+        std::lock_guard<std::mutex> lck(releaseMutex);
+        isReleased = true;
+    }
+    releaseCondition.notify_all();
+
+    // The counter is reported along with the next datagram received after the drops.
+    using namespace std::literals::chrono_literals;
+    for (uint32_t i{0}; (i < 200) && (0 == receiver.kernelDrops(0)); i++) {
+        std::this_thread::sleep_for(10ms);
+        sender.send(std::string(PACKET));
+    }
+    REQUIRE(0 < receiver.kernelDrops(0));
+    REQUIRE(receiver.kernelDrops(0) < SENT);
+    REQUIRE(0 < received.load());
+}
+
+TEST_CASE("Test OxTSHealthPublisher sends the health of every unit.") {
+    std::mutex messagesMutex;
+    std::vector<std::pair<uint32_t, opendlv::system::NetworkStatusMessage>> networks;
+    std::vector<std::pair<uint32_t, opendlv::system::SignalStatusMessage>> signals;
+    cluon::OD4Session od4{251, [&messagesMutex, &networks, &signals](cluon::data::Envelope &&envelope) {
+        std::lock_guard<std::mutex> lck(messagesMutex);
+        if (static_cast<int32_t>(opendlv::system::NetworkStatusMessage::ID()) == envelope.dataType()) {
+            const uint32_t STAMP{envelope.senderStamp()};
+            networks.emplace_back(STAMP, cluon::extractMessage<opendlv::system::NetworkStatusMessage>(std::move(envelope)));
+        } else if (static_cast<int32_t>(opendlv::system::SignalStatusMessage::ID()) == envelope.dataType()) {
+            const uint32_t STAMP{envelope.senderStamp()};
+            signals.emplace_back(STAMP, cluon::extractMessage<opendlv::system::SignalStatusMessage>(std::move(envelope)));
+        }
+    }};
+    REQUIRE(od4.isRunning());
+
+    OxTSDecoder first;
+    OxTSDecoder second;
+    LatencyHistogram latency;
+    latency.record(std::chrono::microseconds{250});
+    spsc::Ring<int, 4> ring;
+    OxTSHealthPublisher health(od4, std::vector<const OxTSDecoder *>{&first, &second}, std::vector<uint32_t>{7, 9}, latency, std::chrono::seconds{1});
+    health.watch(ring.statistics());
+
+    auto awaitMessages = [&messagesMutex, &networks, &signals](std::size_t count) {
+        using namespace std::literals::chrono_literals;
+        for (uint32_t i{0}; i < 100; i++) {
+            {
+                std::lock_guard<std::mutex> lck(messagesMutex);
+                if ( (count <= networks.size()) && (count <= signals.size()) ) {
+                    break;
+                }
+            }
+            std::this_thread::sleep_for(10ms);
+        }
+    };
+
+    const auto START{std::chrono::steady_clock::now()};
+    for (uint32_t i{0}; i < 10; i++) {
+        REQUIRE(first.decode(SAMPLE.data(), SAMPLE.size()).first);
+    }
+    REQUIRE(!first.decode(SAMPLE.data(), SAMPLE.size() - 1).first);
+    REQUIRE(health.publish(START));
+    awaitMessages(2);
+    {
+        std::lock_guard<std::mutex> lck(messagesMutex);
+        REQUIRE(2 == networks.size());
+        REQUIRE(2 == signals.size());
+        std::sort(networks.begin(), networks.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+        std::sort(signals.begin(), signals.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+        REQUIRE(7 + OxTSHealthPublisher::SENDER_STAMP_OFFSET == networks[0].first);
+        REQUIRE(7 + OxTSHealthPublisher::SENDER_STAMP_OFFSET == signals[0].first);
+        REQUIRE(OxTSHealthPublisher::RECEIVING == networks[0].second.code());
+        REQUIRE(std::string::npos != networks[0].second.description().find("packets: 11, kernel drops: 0, queue drops (all units): 0"));
+        REQUIRE(9 + OxTSHealthPublisher::SENDER_STAMP_OFFSET == networks[1].first);
+        REQUIRE(9 + OxTSHealthPublisher::SENDER_STAMP_OFFSET == signals[1].first);
+        REQUIRE(OxTSHealthPublisher::SILENT == networks[1].second.code());
+        REQUIRE(1 == signals[0].second.code());
+        REQUIRE(std::string::npos != signals[0].second.description().find("rejected: 1 (length: 1, sync: 0, checksum 1/2/3: 0/0/0)"));
+        REQUIRE(std::string::npos != signals[0].second.description().find("latency p99: "));
+        REQUIRE(0 == signals[1].second.code());
+        networks.clear();
+        signals.clear();
+    }
+
+    // Not yet due.
+    REQUIRE(!health.publish(START + std::chrono::milliseconds{500}));
+
+    // Drops of the shared queue affect all units.
+    for (uint32_t i{0}; i < 5; i++) {
+        ring.push(i);
+    }
+    for (uint32_t i{0}; i < 20; i++) {
+        REQUIRE(second.decode(SAMPLE.data(), SAMPLE.size()).first);
+    }
+    REQUIRE(health.publish(START + std::chrono::seconds{2}));
+    awaitMessages(2);
+    {
+        std::lock_guard<std::mutex> lck(messagesMutex);
+        REQUIRE(2 == networks.size());
+        std::sort(networks.begin(), networks.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+        REQUIRE(OxTSHealthPublisher::DROPPING == networks[0].second.code());
+        REQUIRE(OxTSHealthPublisher::DROPPING == networks[1].second.code());
+        REQUIRE(std::string::npos != networks[1].second.description().find("rate: 10.0 packets/s, packets: 20"));
+        REQUIRE(std::string::npos != networks[1].second.description().find("queue drops (all units): 1"));
+        REQUIRE(0 == signals[0].second.code());
+    }
+}
+
+TEST_CASE("Test OxTSStatusReporter summarizes several units.") {
+    OxTSDecoder d0;
+    OxTSDecoder d1;
+    LatencyHistogram latency;
+    d1.decode(SAMPLE.data(), SAMPLE.size());
+    std::stringstream output;
+    OxTSStatusReporter reporter(std::vector<const OxTSDecoder *>{&d0, &d1}, latency, OxTSStatusReporter::SUMMARY, std::chrono::hours{1}, output);
+    reporter.update(1, 57.7, 11.9, 2.0f);
+    reporter.update(7, 0.0, 0.0, 0.0f);
+
+    const std::string S{reporter.summary(std::chrono::seconds{1})};
+    REQUIRE(std::string::npos != S.find("[oxts] unit 0: 0.0 packets/s, 0 packets, 0 rejected, 0 checksum errors, 0 missing, no fix\n"));
+    REQUIRE(std::string::npos != S.find("[oxts] unit 1: 1.0 packets/s, 1 packets, 0 rejected, 0 checksum errors, 0 missing, last fix: latitude = 57.7"));
+    REQUIRE(std::string::npos != S.find("\n[oxts] all units"));
+
+    // A summary never mixes the fields of two fixes written concurrently.
+    OxTSStatusReporter single(d0, latency, OxTSStatusReporter::SUMMARY, std::chrono::hours{1}, output);
+    single.update(0.0, 0.0, 0.0f);
+    std::atomic<bool> running{true};
+    std::thread writer([&single, &running]() {
+        for (uint32_t i{0}; running.load(std::memory_order_relaxed); i = (i + 1) % 1000) {
+            single.update(i, i, static_cast<float>(i));
+        }
+    });
+    uint32_t checked{0};
+    uint32_t mixed{0};
+    for (uint32_t i{0}; i < 2000; i++) {
+        const std::string SUMMARY{single.summary(std::chrono::seconds{1})};
+        const std::size_t LATITUDE{SUMMARY.find("latitude = ")};
+        const std::size_t LONGITUDE{SUMMARY.find(", longitude = ")};
+        const std::size_t HEADING{SUMMARY.find(", northHeading = ")};
+        if ( (std::string::npos != LATITUDE) && (std::string::npos != LONGITUDE) && (std::string::npos != HEADING) ) {
+            const std::string LAT{SUMMARY.substr(LATITUDE + 11, LONGITUDE - LATITUDE - 11)};
+            const std::string LON{SUMMARY.substr(LONGITUDE + 14, HEADING - LONGITUDE - 14)};
+            mixed += (LAT == LON) ? 0 : 1;
+            checked++;
+        }
+    }
+    running.store(false);
+    writer.join();
+    REQUIRE(2000 == checked);
+    REQUIRE(0 == mixed);
+}
+
+TEST_CASE("Test spsc::Ring overflow policies and counters.") {
+    spsc::Ring<uint32_t, 4> drop;
+    REQUIRE(drop.empty());
+    REQUIRE(nullptr == drop.front());
+    for (uint32_t i{0}; i < 6; i++) {
+        REQUIRE((i < 4) == drop.push(i));
+    }
+    REQUIRE(4 == drop.statistics().pushed.load());
+    REQUIRE(2 == drop.statistics().dropped.load());
+    REQUIRE(4 == drop.statistics().maxDepth.load());
+    REQUIRE(4 == drop.statistics().depth());
+    for (uint32_t i{0}; i < 3; i++) {
+        REQUIRE(nullptr != drop.front());
+        REQUIRE(i == *drop.front());
+        drop.pop();
+    }
+    REQUIRE(1 == drop.statistics().depth());
+    // Wrap around.
+    REQUIRE(drop.push(10));
+    REQUIRE(3 == *drop.front());
+    drop.pop();
+    REQUIRE(10 == *drop.front());
+    drop.pop();
+    REQUIRE(drop.empty());
+
+    // A blocking push gives up and drops once not running anymore.
+    spsc::Ring<uint32_t, 2> block(spsc::Overflow::BLOCK);
+    std::atomic<bool> running{false};
+    REQUIRE(block.push(1, &running));
+    REQUIRE(block.push(2, &running));
+    REQUIRE(!block.push(3, &running));
+    REQUIRE(1 == block.statistics().dropped.load());
+}
+
+TEST_CASE("Test spsc::Ring transfers all elements in order between two threads.") {
+    constexpr uint32_t COUNT{100000};
+    spsc::Ring<uint32_t, 64> ring(spsc::Overflow::BLOCK);
+    std::thread producer([&ring]() {
+        for (uint32_t i{0}; i < COUNT; i++) {
+            ring.push(i);
+        }
+    });
+
+    uint32_t expected{0};
+    bool inOrder{true};
+    while (expected < COUNT) {
+        const uint32_t *e{ring.front()};
+        if (nullptr != e) {
+            inOrder = inOrder && (expected == *e);
+            ring.pop();
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    REQUIRE(inOrder);
+    REQUIRE(0 == ring.statistics().dropped.load());
+    REQUIRE(COUNT == ring.statistics().popped.load());
+    REQUIRE(ring.empty());
+}
+
+TEST_CASE("Test OxTSPipeline hands queued packets to its thread.") {
+    std::mutex lengthsMutex;
+    std::vector<std::size_t> lengths;
+    std::vector<std::chrono::system_clock::time_point> stamps;
+    std::atomic<uint32_t> idles{0};
+    {
+        OxTSPipeline pipeline(spsc::Overflow::DROP_NEWEST,
+            [&lengthsMutex, &lengths, &stamps](uint32_t unit, const uint8_t *data, std::size_t length, const std::chrono::system_clock::time_point &tp) noexcept {
+            std::lock_guard<std::mutex> lck(lengthsMutex);
+            lengths.push_back((0 < length) && (ncom::SYNC == data[0]) ? length + 1000 * unit : 0);
+            stamps.push_back(tp);
+        },
+            [&idles]() noexcept {
+            idles++;
+        });
+
+        const std::chrono::system_clock::time_point T1{std::chrono::seconds{1}};
+        const std::chrono::system_clock::time_point T2{std::chrono::seconds{2}};
+        REQUIRE(pipeline.push(0, SAMPLE.data(), SAMPLE.size(), T1));
+        // Let the consumer fall asleep before pushing the next one.
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        std::vector<uint8_t> oversized(200, ncom::SYNC);
+        REQUIRE(pipeline.push(2, oversized.data(), oversized.size(), T2));
+
+        for (uint32_t i{0}; i < 100; i++) {
+            {
+                std::lock_guard<std::mutex> lck(lengthsMutex);
+                if (2 == lengths.size()) {
+                    break;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        REQUIRE(2 == pipeline.statistics().popped.load());
+        REQUIRE(0 == pipeline.statistics().dropped.load());
+
+        // The idle delegate is called while no packets are queued.
+        for (uint32_t i{0}; (i < 100) && (0 == idles.load()); i++) {
+            std::this_thread::sleep_for(OxTSPipeline::IDLE_INTERVAL);
+        }
+        REQUIRE(0 < idles.load());
+
+        // Once stopped, the delegates are no longer called.
+        pipeline.stop();
+        const uint32_t IDLES{idles.load()};
+        pipeline.push(0, SAMPLE.data(), SAMPLE.size(), T1);
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        REQUIRE(2 == pipeline.statistics().popped.load());
+        REQUIRE(IDLES == idles.load());
+        pipeline.stop();
+
+        std::lock_guard<std::mutex> lck(lengthsMutex);
+        REQUIRE(2 == lengths.size());
+        REQUIRE(ncom::PACKET_LENGTH == lengths[0]);
+        REQUIRE(2000 + ncom::PACKET_LENGTH + 1 == lengths[1]);
+        REQUIRE(T1 == stamps[0]);
+        REQUIRE(T2 == stamps[1]);
+    }
+}
+
+namespace {
+// Copy of SAMPLE with the given time and status channel, and recomputed checksums.
+std::vector<uint8_t> samplePacketAt(uint16_t time, uint8_t channel, const std::array<uint8_t, ncom::status::DATA_LENGTH> &status) {
+    std::vector<uint8_t> packet{SAMPLE};
+    std::memcpy(&packet[ncom::Time::OFFSET], &time, sizeof(time));
+    packet[ncom::StatusChannel::OFFSET] = channel;
+    std::copy(status.begin(), status.end(), packet.begin() + ncom::status::DATA_OFFSET);
+    updateChecksums(packet);
+    return packet;
+}
+
+std::vector<uint8_t> samplePacketAt(uint16_t time, uint8_t channel, uint32_t gpsMinutes) {
+    std::array<uint8_t, ncom::status::DATA_LENGTH> status{};
+    std::memcpy(status.data(), &gpsMinutes, sizeof(gpsMinutes));
+    return samplePacketAt(time, channel, status);
+}
+} // namespace
+
+TEST_CASE("Test OxTSDecoder extracts GPS time.") {
+    OxTSDecoder d;
+    OxTSDecoder::Readings readings;
+
+    // The GPS minute is unknown until status channel 0 was received.
+    REQUIRE(d.decode(SAMPLE.data(), SAMPLE.size(), readings));
+    REQUIRE(38300 == readings.time);
+    REQUIRE(!readings.hasGpsTime);
+
+    constexpr uint32_t MINUTES{20000000};
+    std::vector<uint8_t> packet{samplePacketAt(59990, ncom::status::GPS_TIME_CHANNEL, MINUTES)};
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE((OxTSDecoder::BATCH_A | OxTSDecoder::BATCH_B | OxTSDecoder::BATCH_S) == readings.batches);
+    REQUIRE(readings.hasGpsTime);
+    REQUIRE((std::chrono::minutes{MINUTES} + std::chrono::milliseconds{59990}) == readings.gpsTime);
+
+    // The minute is carried on across other status channels and wraps around with the milliseconds.
+    packet = samplePacketAt(10, 29, 0);
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE(readings.hasGpsTime);
+    REQUIRE((std::chrono::minutes{MINUTES + 1} + std::chrono::milliseconds{10}) == readings.gpsTime);
+
+    // Corrupted status channel: the minute is not taken from it.
+    packet = samplePacketAt(20, ncom::status::GPS_TIME_CHANNEL, 5);
+    packet[ncom::Checksum3::OFFSET]++;
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE(readings.hasGpsTime);
+    REQUIRE((std::chrono::minutes{MINUTES + 1} + std::chrono::milliseconds{20}) == readings.gpsTime);
+
+    // Invalid time within the minute.
+    packet = samplePacketAt(ncom::MILLISECONDS_PER_MINUTE, 29, 0);
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE(!readings.hasGpsTime);
+}
+
+TEST_CASE("Test OxTSDecoder assembles the status channels and reports changes.") {
+    OxTSDecoder d;
+    OxTSDecoder::Readings readings;
+    REQUIRE(0 == d.status().valid);
+
+    // Channel 0: minutes, 9 satellites, and modes 4, 5, 6.
+    std::vector<uint8_t> packet{samplePacketAt(0, ncom::status::GPS_TIME_CHANNEL, {{0x01, 0x00, 0x00, 0x00, 9, 4, 5, 6}})};
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE((OxTSDecoder::GNSS_STATE | OxTSDecoder::NAVIGATION_STATUS) == readings.statusChanges);
+    REQUIRE((OxTSDecoder::GNSS_STATE | OxTSDecoder::NAVIGATION_STATUS) == d.status().valid);
+    REQUIRE(ncom::navigation::LOCKED == d.status().navigationStatus);
+    REQUIRE(9 == d.status().satellites);
+    REQUIRE(4 == d.status().positionMode);
+    REQUIRE(5 == d.status().velocityMode);
+    REQUIRE(6 == d.status().orientationMode);
+
+    // Repeated channel and channels not interpreted.
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE(0 == readings.statusChanges);
+    REQUIRE(d.decode(SAMPLE.data(), SAMPLE.size(), readings));
+    REQUIRE(0 == readings.statusChanges);
+
+    // A new minute alone does not change the state.
+    packet = samplePacketAt(0, ncom::status::GPS_TIME_CHANNEL, {{0x02, 0x00, 0x00, 0x00, 9, 4, 5, 6}});
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE(0 == readings.statusChanges);
+    packet = samplePacketAt(0, ncom::status::GPS_TIME_CHANNEL, {{0x02, 0x00, 0x00, 0x00, 10, 4, 5, 6}});
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE(OxTSDecoder::GNSS_STATE == readings.statusChanges);
+    REQUIRE(10 == d.status().satellites);
+
+    // Position accuracy 0.010/0.020/0.300 m.
+    packet = samplePacketAt(0, ncom::status::POSITION_ACCURACY_CHANNEL, {{10, 0, 20, 0, 0x2c, 0x01, 3, 0}});
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE(OxTSDecoder::POSITION_ACCURACY == readings.statusChanges);
+    REQUIRE((OxTSDecoder::GNSS_STATE | OxTSDecoder::NAVIGATION_STATUS | OxTSDecoder::POSITION_ACCURACY) == d.status().valid);
+    REQUIRE(0.01f == Approx(d.status().positionAccuracy[0]));
+    REQUIRE(0.02f == Approx(d.status().positionAccuracy[1]));
+    REQUIRE(0.3f == Approx(d.status().positionAccuracy[2]));
+
+    // Aging accuracies are unchanged until they become too old.
+    packet = samplePacketAt(0, ncom::status::POSITION_ACCURACY_CHANNEL, {{10, 0, 20, 0, 0x2c, 0x01, 4, 0}});
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE(0 == readings.statusChanges);
+    packet = samplePacketAt(0, ncom::status::POSITION_ACCURACY_CHANNEL, {{10, 0, 20, 0, 0x2c, 0x01, ncom::status::MAX_ACCURACY_AGE, 0}});
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE(OxTSDecoder::POSITION_ACCURACY == readings.statusChanges);
+    REQUIRE((OxTSDecoder::GNSS_STATE | OxTSDecoder::NAVIGATION_STATUS) == d.status().valid);
+
+    // Velocity [m/s] and orientation [rad] accuracies.
+    packet = samplePacketAt(0, ncom::status::VELOCITY_ACCURACY_CHANNEL, {{5, 0, 6, 0, 7, 0, 0, 0}});
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE(OxTSDecoder::VELOCITY_ACCURACY == readings.statusChanges);
+    REQUIRE(0.007f == Approx(d.status().velocityAccuracy[2]));
+    packet = samplePacketAt(0, ncom::status::ORIENTATION_ACCURACY_CHANNEL, {{100, 0, 50, 0, 25, 0, 0, 0}});
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE(OxTSDecoder::ORIENTATION_ACCURACY == readings.statusChanges);
+    REQUIRE(0.001f == Approx(d.status().orientationAccuracy[0]));
+    REQUIRE((OxTSDecoder::GNSS_STATE | OxTSDecoder::NAVIGATION_STATUS | OxTSDecoder::VELOCITY_ACCURACY | OxTSDecoder::ORIENTATION_ACCURACY) == d.status().valid);
+
+    // Corrupted status channels are ignored.
+    packet = samplePacketAt(0, ncom::status::GPS_TIME_CHANNEL, {{0x02, 0x00, 0x00, 0x00, 11, 4, 5, 6}});
+    packet[ncom::Checksum3::OFFSET]++;
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE(0 == readings.statusChanges);
+    REQUIRE(10 == d.status().satellites);
+}
+
+TEST_CASE("Test OxTSDecoder gates packets by navigation status.") {
+    auto withNavigationStatus = [](uint8_t navigationStatus) {
+        std::vector<uint8_t> packet{samplePacketAt(1000, ncom::status::GPS_TIME_CHANNEL, 1)};
+        // Keep all checksums valid.
+        const uint8_t DELTA{static_cast<uint8_t>(navigationStatus - packet[ncom::NavigationStatus::OFFSET])};
+        packet[ncom::NavigationStatus::OFFSET] = navigationStatus;
+        packet[ncom::Checksum1::OFFSET] = static_cast<uint8_t>(packet[ncom::Checksum1::OFFSET] + DELTA);
+        packet[ncom::Checksum2::OFFSET] = static_cast<uint8_t>(packet[ncom::Checksum2::OFFSET] + 2 * DELTA);
+        packet[ncom::Checksum3::OFFSET] = static_cast<uint8_t>(packet[ncom::Checksum3::OFFSET] + 4 * DELTA);
+        return packet;
+    };
+
+    OxTSDecoder d{OxTSDecoder::Gating::LOCKED};
+    OxTSDecoder::Readings readings;
+    std::vector<uint8_t> packet{withNavigationStatus(ncom::navigation::INITIALISING)};
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE(OxTSDecoder::BATCH_S == readings.batches);
+    REQUIRE((OxTSDecoder::NAVIGATION_STATUS | OxTSDecoder::GNSS_STATE) == readings.statusChanges);
+    REQUIRE(ncom::navigation::INITIALISING == d.status().navigationStatus);
+    REQUIRE(readings.hasGpsTime);
+    REQUIRE(!d.decode(packet.data(), packet.size()).first);
+
+    packet = withNavigationStatus(ncom::navigation::LOCKING);
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE(OxTSDecoder::BATCH_S == readings.batches);
+    REQUIRE(OxTSDecoder::NAVIGATION_STATUS == readings.statusChanges);
+
+    packet = withNavigationStatus(ncom::navigation::RAW_IMU);
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE((OxTSDecoder::BATCH_A | OxTSDecoder::BATCH_S) == readings.batches);
+
+    packet = withNavigationStatus(ncom::navigation::TRIGGER_LOCKED);
+    REQUIRE(!d.decode(packet.data(), packet.size(), readings));
+    REQUIRE(0 == readings.batches);
+    REQUIRE(OxTSDecoder::NAVIGATION_STATUS == readings.statusChanges);
+    REQUIRE(ncom::navigation::TRIGGER_LOCKED == d.status().navigationStatus);
+
+    packet = withNavigationStatus(ncom::navigation::LOCKED);
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE((OxTSDecoder::BATCH_A | OxTSDecoder::BATCH_B | OxTSDecoder::BATCH_S) == readings.batches);
+    REQUIRE(OxTSDecoder::NAVIGATION_STATUS == readings.statusChanges);
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE(0 == readings.statusChanges);
+
+    REQUIRE(7 == d.statistics().packets.load());
+    REQUIRE(5 == d.statistics().gated.load());
+    REQUIRE(0 == d.statistics().rejected.load());
+
+    // Batches of packets.
+    std::vector<uint8_t> packets{withNavigationStatus(ncom::navigation::LOCKING)};
+    packet = withNavigationStatus(ncom::navigation::LOCKED);
+    packets.insert(packets.end(), packet.begin(), packet.end());
+    std::array<double, 2> latitude;
+    std::array<uint8_t, 2> valid;
+    OxTSDecoder::Columns columns;
+    columns.latitude = latitude.data();
+    columns.valid    = valid.data();
+    REQUIRE(1 == d.decodeBatch(packets.data(), 2, columns));
+    REQUIRE(0 == valid[0]);
+    REQUIRE(1 == valid[1]);
+    REQUIRE(0.0 == latitude[0]);
+    REQUIRE(6 == d.statistics().gated.load());
+
+    // Without gating, which is the default, the navigation status is only reported.
+    OxTSDecoder ungated;
+    packet = withNavigationStatus(ncom::navigation::LOCKING);
+    REQUIRE(ungated.decode(packet.data(), packet.size(), readings));
+    REQUIRE((OxTSDecoder::BATCH_A | OxTSDecoder::BATCH_B | OxTSDecoder::BATCH_S) == readings.batches);
+    REQUIRE(ncom::navigation::LOCKING == ungated.status().navigationStatus);
+    REQUIRE(2 == ungated.decodeBatch(packets.data(), 2, columns));
+    REQUIRE(0 == ungated.statistics().gated.load());
+}
+
+namespace {
+// Collects the envelopes of an OD4 session; a marker (any message with the
+// senderStamp MARKER) sent behind the messages under test tells that all of them arrived.
+class EnvelopeCollector {
+   private:
+    EnvelopeCollector(const EnvelopeCollector &) = delete;
+    EnvelopeCollector(EnvelopeCollector &&)      = delete;
+    EnvelopeCollector &operator=(const EnvelopeCollector &) = delete;
+    EnvelopeCollector &operator=(EnvelopeCollector &&) = delete;
+
+   public:
+    static constexpr uint32_t MARKER{4711};
+
+    explicit EnvelopeCollector(uint16_t cid)
+        : m_od4{cid, [this](cluon::data::Envelope &&envelope) {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            m_envelopes.push_back(std::move(envelope));
+        }} {}
+
+    cluon::OD4Session &od4() noexcept {
+        return m_od4;
+    }
+
+    // @return true if the next marker arrived within 2 s; envelopes are those received before it.
+    bool awaitMarker(std::vector<cluon::data::Envelope> &envelopes) {
+        for (uint32_t i{0}; i < 200; i++) {
+            {
+                std::lock_guard<std::mutex> lck(m_mutex);
+                auto marker = std::find_if(m_envelopes.begin(), m_envelopes.end(), [](const cluon::data::Envelope &envelope) {
+                    return MARKER == envelope.senderStamp();
+                });
+                if (m_envelopes.end() != marker) {
+                    envelopes.assign(m_envelopes.begin(), marker);
+                    m_envelopes.erase(m_envelopes.begin(), marker + 1);
+                    return true;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+        return false;
+    }
+
+   private:
+    std::mutex m_mutex{};
+    std::vector<cluon::data::Envelope> m_envelopes{};
+    cluon::OD4Session m_od4;
+};
+
+constexpr uint32_t EnvelopeCollector::MARKER;
+} // namespace
+
+TEST_CASE("Test OxTSForwarder sends the navigation and GNSS state on change and once per interval.") {
+    using std::chrono::milliseconds;
+    EnvelopeCollector collector{249};
+    REQUIRE(collector.od4().isRunning());
+    od4::Publisher publisher{249};
+    OxTSForwarder forwarder{publisher, collector.od4(), 3};
+
+    // Without batches, only the state is sent.
+    OxTSDecoder::Readings readings;
+    OxTSDecoder::Status status;
+    status.valid            = OxTSDecoder::NAVIGATION_STATUS | OxTSDecoder::GNSS_STATE;
+    status.navigationStatus = ncom::navigation::LOCKED;
+    status.satellites       = 9;
+    status.positionMode     = 4;
+    const std::chrono::system_clock::time_point START{std::chrono::hours{400000}};
+    auto forwardAt = [&](milliseconds elapsed, uint32_t statusChanges) {
+        readings.statusChanges = statusChanges;
+        return forwarder.forward(readings, status, cluon::data::TimeStamp{}, START + elapsed);
+    };
+
+    REQUIRE(!forwardAt(milliseconds{0}, OxTSDecoder::NAVIGATION_STATUS | OxTSDecoder::GNSS_STATE));
+    forwardAt(milliseconds{100}, 0);
+    status.positionMode = 5;
+    forwardAt(milliseconds{200}, OxTSDecoder::GNSS_STATE);
+    status.navigationStatus = ncom::navigation::LOCKING;
+    forwardAt(milliseconds{300}, OxTSDecoder::NAVIGATION_STATUS);
+    forwardAt(milliseconds{999}, 0);
+    // Repeated once per interval.
+    forwardAt(milliseconds{1000}, 0);
+    forwardAt(milliseconds{1500}, 0);
+    // Invalid state is never sent.
+    status.valid = 0;
+    forwardAt(milliseconds{2000}, OxTSDecoder::NAVIGATION_STATUS | OxTSDecoder::GNSS_STATE);
+    // A clock stepped back repeats the state right away.
+    status.valid = OxTSDecoder::NAVIGATION_STATUS;
+    forwardAt(milliseconds{500}, 0);
+
+    opendlv::proxy::GroundSpeedReading marker;
+    collector.od4().send(marker, cluon::data::TimeStamp{}, EnvelopeCollector::MARKER);
+    std::vector<cluon::data::Envelope> envelopes;
+    REQUIRE(collector.awaitMarker(envelopes));
+
+    const int32_t NAVIGATION{static_cast<int32_t>(opendlv::system::SystemOperationState::ID())};
+    const int32_t GNSS{static_cast<int32_t>(opendlv::system::SignalStatusMessage::ID())};
+    std::vector<std::pair<int32_t, int32_t>> states;
+    std::vector<std::string> descriptions;
+    for (auto &envelope : envelopes) {
+        REQUIRE(3 == envelope.senderStamp());
+        if (NAVIGATION == envelope.dataType()) {
+            const auto STATE = cluon::extractMessage<opendlv::system::SystemOperationState>(std::move(envelope));
+            states.emplace_back(NAVIGATION, STATE.code());
+            descriptions.push_back(STATE.description());
+        } else if (GNSS == envelope.dataType()) {
+            const auto STATE = cluon::extractMessage<opendlv::system::SignalStatusMessage>(std::move(envelope));
+            states.emplace_back(GNSS, STATE.code());
+            descriptions.push_back(STATE.description());
+        }
+    }
+    const std::vector<std::pair<int32_t, int32_t>> EXPECTED{
+        {NAVIGATION, ncom::navigation::LOCKED}, {GNSS, 4},
+        {GNSS, 5},
+        {NAVIGATION, ncom::navigation::LOCKING},
+        {NAVIGATION, ncom::navigation::LOCKING}, {GNSS, 5},
+        {NAVIGATION, ncom::navigation::LOCKING}};
+    REQUIRE(EXPECTED == states);
+    REQUIRE("locked" == descriptions[0]);
+    REQUIRE("satellites: 9, position mode: 4, velocity mode: 0, orientation mode: 0" == descriptions[1]);
+    REQUIRE("locking" == descriptions[3]);
 }
 
+TEST_CASE("Test OxTSForwarder sends the valid accuracies with every fix.") {
+    EnvelopeCollector collector{248};
+    REQUIRE(collector.od4().isRunning());
+    od4::Publisher publisher{248};
+    OxTSForwarder forwarder{publisher, collector.od4(), 5};
+    OxTSDecoder d{OxTSDecoder::Gating::NONE};
+    OxTSDecoder::Readings readings;
+
+    // @return The SensorInfo forwarded with the packet as (description, signalId, accuracyStd).
+    uint16_t time{0};
+    auto forward = [&](uint8_t channel, const std::array<uint8_t, ncom::status::DATA_LENGTH> &status) {
+        const std::vector<uint8_t> PACKET{samplePacketAt(time, channel, status)};
+        time = static_cast<uint16_t>(time + 10);
+        REQUIRE(d.decode(PACKET.data(), PACKET.size(), readings));
+        REQUIRE(forwarder.forward(readings, d.status(), cluon::data::TimeStamp{}, std::chrono::system_clock::now()));
+        // Sent through the same socket as the readings.
+        opendlv::proxy::AltitudeReading marker;
+        publisher.queue(marker, cluon::data::TimeStamp{}, EnvelopeCollector::MARKER);
+        publisher.flush();
+        std::vector<cluon::data::Envelope> envelopes;
+        REQUIRE(collector.awaitMarker(envelopes));
+        std::vector<std::tuple<std::string, uint32_t, float>> infos;
+        for (auto &envelope : envelopes) {
+            if (static_cast<int32_t>(opendlv::body::SensorInfo::ID()) == envelope.dataType()) {
+                REQUIRE(5 == envelope.senderStamp());
+                const auto INFO = cluon::extractMessage<opendlv::body::SensorInfo>(std::move(envelope));
+                infos.emplace_back(INFO.description(), INFO.signalId(), INFO.accuracyStd());
+            }
+        }
+        return infos;
+    };
+    const uint32_t POSITION{opendlv::proxy::GeodeticWgs84Reading::ID()};
+    const uint32_t ALTITUDE{opendlv::proxy::AltitudeReading::ID()};
+    const uint32_t HEADING{opendlv::proxy::GeodeticHeadingReading::ID()};
+    const uint32_t VELOCITY{opendlv::logic::sensation::Equilibrioception::ID()};
+
+    // Nothing is known about the accuracies before their status channels arrived.
+    REQUIRE(forward(ncom::status::GPS_TIME_CHANNEL, {{0x01, 0x00, 0x00, 0x00, 9, 4, 5, 6}}).empty());
+
+    // North/east/down standard deviations of 3/4/12 m; too old to be valid.
+    REQUIRE(forward(ncom::status::POSITION_ACCURACY_CHANNEL, {{0xB8, 0x0B, 0xA0, 0x0F, 0xE0, 0x2E, ncom::status::MAX_ACCURACY_AGE, 0}}).empty());
+    auto infos = forward(ncom::status::POSITION_ACCURACY_CHANNEL, {{0xB8, 0x0B, 0xA0, 0x0F, 0xE0, 0x2E, 10, 0}});
+    REQUIRE(2 == infos.size());
+    REQUIRE("position" == std::get<0>(infos[0]));
+    REQUIRE(POSITION == std::get<1>(infos[0]));
+    REQUIRE(5.0f == Approx(std::get<2>(infos[0])));
+    REQUIRE("altitude" == std::get<0>(infos[1]));
+    REQUIRE(ALTITUDE == std::get<1>(infos[1]));
+    REQUIRE(12.0f == Approx(std::get<2>(infos[1])));
+
+    // Heading/pitch/roll of 0.01/0.02/0.03 rad.
+    infos = forward(ncom::status::ORIENTATION_ACCURACY_CHANNEL, {{0xE8, 0x03, 0xD0, 0x07, 0xB8, 0x0B, 10, 0}});
+    REQUIRE(3 == infos.size());
+    REQUIRE("heading" == std::get<0>(infos[2]));
+    REQUIRE(HEADING == std::get<1>(infos[2]));
+    REQUIRE(0.01f == Approx(std::get<2>(infos[2])));
+
+    // North/east/down of 1/2/2 m/s combine to 3 m/s.
+    infos = forward(ncom::status::VELOCITY_ACCURACY_CHANNEL, {{0xE8, 0x03, 0xD0, 0x07, 0xD0, 0x07, 10, 0}});
+    REQUIRE(4 == infos.size());
+    REQUIRE("velocity" == std::get<0>(infos[3]));
+    REQUIRE(VELOCITY == std::get<1>(infos[3]));
+    REQUIRE(3.0f == Approx(std::get<2>(infos[3])));
+
+    // Accompanying every fix, also of packets with other status channels.
+    infos = forward(ncom::status::GPS_TIME_CHANNEL, {{0x01, 0x00, 0x00, 0x00, 9, 4, 5, 6}});
+    REQUIRE(4 == infos.size());
+    REQUIRE(POSITION == std::get<1>(infos[0]));
+    REQUIRE(ALTITUDE == std::get<1>(infos[1]));
+
+    // Once aged, the position's accuracies are withheld while the others are still sent.
+    infos = forward(ncom::status::POSITION_ACCURACY_CHANNEL, {{0xB8, 0x0B, 0xA0, 0x0F, 0xE0, 0x2E, 200, 0}});
+    REQUIRE(2 == infos.size());
+    REQUIRE(HEADING == std::get<1>(infos[0]));
+    REQUIRE(VELOCITY == std::get<1>(infos[1]));
+}
+
+TEST_CASE("Test ClockOffsetEstimator maps GPS time onto system_clock despite jitter.") {
+    using std::chrono::microseconds;
+    using std::chrono::milliseconds;
+    using std::chrono::nanoseconds;
+
+    // GPS epoch in system_clock plus leap seconds, and 20 ppm drift.
+    const nanoseconds OFFSET{std::chrono::seconds{315964800 - 18}};
+    constexpr double DRIFT{20e-6};
+    const nanoseconds MIN_DELAY{microseconds{300}};
+    const nanoseconds START{std::chrono::minutes{20000000}};
+    std::minstd_rand random{1};
+    std::uniform_int_distribution<int64_t> jitter{0, 500000};
+    std::uniform_int_distribution<int64_t> outlier{0, 20000000};
+
+    auto expected = [&](nanoseconds gpsTime) {
+        const nanoseconds DRIFTED{static_cast<int64_t>(DRIFT * static_cast<double>((gpsTime - START).count()))};
+        return std::chrono::system_clock::time_point{std::chrono::duration_cast<std::chrono::system_clock::duration>(gpsTime + OFFSET + DRIFTED + MIN_DELAY)};
+    };
+    auto received = [&](nanoseconds gpsTime, nanoseconds step) {
+        const nanoseconds DELAY{(0 == random() % 10) ? outlier(random) : jitter(random)};
+        return expected(gpsTime) + std::chrono::duration_cast<std::chrono::system_clock::duration>(DELAY + step);
+    };
+
+    ClockOffsetEstimator clock;
+    nanoseconds gpsTime{START};
+    for (uint32_t i{0}; i < ClockOffsetEstimator::MIN_SAMPLES - 1; i++, gpsTime += milliseconds{10}) {
+        clock.add(gpsTime, received(gpsTime, nanoseconds{0}));
+    }
+    REQUIRE(!clock.isLocked());
+
+    for (uint32_t i{0}; i < 2000; i++, gpsTime += milliseconds{10}) {
+        clock.add(gpsTime, received(gpsTime, nanoseconds{0}));
+        if (clock.isLocked()) {
+            // Lower envelope of a few samples only at first.
+            const nanoseconds ERROR{clock.toSystemClock(gpsTime) - expected(gpsTime)};
+            REQUIRE(std::abs(ERROR.count()) < nanoseconds{microseconds{(i < 500) ? 1000 : 50}}.count());
+        }
+    }
+    const ClockOffsetEstimator::Health &health = clock.health();
+    REQUIRE(clock.isLocked());
+    REQUIRE(health.isLocked.load());
+    REQUIRE(ClockOffsetEstimator::MIN_SAMPLES - 1 + 2000 == health.samples.load());
+    REQUIRE(0 == health.resets.load());
+    REQUIRE(DRIFT * 1e6 == Approx(health.drift.load()).margin(5.0));
+    REQUIRE(0 <= health.medianResidual.load());
+    REQUIRE(health.medianResidual.load() < nanoseconds{microseconds{500}}.count());
+    REQUIRE(health.medianResidual.load() <= health.maxResidual.load());
+
+    // Stepping system_clock back restarts the estimation.
+    clock.add(gpsTime, received(gpsTime, -std::chrono::seconds{1}));
+    REQUIRE(!clock.isLocked());
+    REQUIRE(1 == health.resets.load());
+    gpsTime += milliseconds{10};
+    for (uint32_t i{0}; i < 1000; i++, gpsTime += milliseconds{10}) {
+        clock.add(gpsTime, received(gpsTime, -std::chrono::seconds{1}));
+    }
+    REQUIRE(clock.isLocked());
+    const nanoseconds ERROR{clock.toSystemClock(gpsTime) - (expected(gpsTime) - std::chrono::seconds{1})};
+    REQUIRE(std::abs(ERROR.count()) < nanoseconds{microseconds{50}}.count());
+
+    // A restarted unit's time going backwards restarts the estimation as well.
+    clock.add(START, received(START, nanoseconds{0}));
+    REQUIRE(!clock.isLocked());
+    REQUIRE(2 == health.resets.load());
+}
+
+TEST_CASE("Test ClockOffsetEstimator skips late samples.") {
+    using std::chrono::milliseconds;
+    using std::chrono::nanoseconds;
+    const nanoseconds START{std::chrono::minutes{20000000}};
+    const nanoseconds OFFSET{std::chrono::seconds{315964800 - 18}};
+    auto received = [&OFFSET](nanoseconds gpsTime, milliseconds delay) {
+        return std::chrono::system_clock::time_point{std::chrono::duration_cast<std::chrono::system_clock::duration>(gpsTime + OFFSET + delay)};
+    };
+
+    ClockOffsetEstimator clock;
+    const ClockOffsetEstimator::Health &health = clock.health();
+    nanoseconds gpsTime{START};
+    for (uint32_t i{0}; i < 2 * ClockOffsetEstimator::MIN_SAMPLES; i++, gpsTime += milliseconds{10}) {
+        clock.add(gpsTime, received(gpsTime, milliseconds{0}));
+    }
+    REQUIRE(clock.isLocked());
+    const uint64_t SAMPLES{health.samples.load()};
+
+    // A packet reordered by 10 ms arrives after its successor.
+    const nanoseconds NEWEST{gpsTime - milliseconds{10}};
+    clock.add(NEWEST - milliseconds{10}, received(NEWEST, milliseconds{1}));
+    REQUIRE(clock.isLocked());
+    REQUIRE(0 == health.resets.load());
+    REQUIRE(1 == health.late.load());
+    REQUIRE(SAMPLES == health.samples.load());
+    REQUIRE(std::abs((clock.toSystemClock(NEWEST) - received(NEWEST, milliseconds{0})).count()) < nanoseconds{std::chrono::microseconds{1}}.count());
+
+    // Duplicates are neither counted as late nor do they restart.
+    clock.add(NEWEST, received(NEWEST, milliseconds{1}));
+    REQUIRE(1 == health.late.load());
+    clock.add(gpsTime, received(gpsTime, milliseconds{0}));
+    REQUIRE(SAMPLES + 1 == health.samples.load());
+
+    // Within the horizon, a packet is still late; beyond, the unit's time jumped back.
+    clock.add(gpsTime - ClockOffsetEstimator::HORIZON, received(gpsTime, milliseconds{0}));
+    REQUIRE(clock.isLocked());
+    REQUIRE(2 == health.late.load());
+    clock.add(gpsTime - ClockOffsetEstimator::HORIZON - milliseconds{10}, received(gpsTime, milliseconds{0}));
+    REQUIRE(!clock.isLocked());
+    REQUIRE(1 == health.resets.load());
+
+    // The horizon follows the units' output rate.
+    ClockOffsetEstimator slow{milliseconds{64000}};
+    for (uint32_t i{0}; i < ClockOffsetEstimator::MIN_SAMPLES; i++) {
+        slow.add(START + std::chrono::seconds{i}, received(START + std::chrono::seconds{i}, milliseconds{0}));
+    }
+    slow.add(START, received(START + std::chrono::seconds{ClockOffsetEstimator::MIN_SAMPLES}, milliseconds{0}));
+    REQUIRE(slow.isLocked());
+    REQUIRE(1 == slow.health().late.load());
+}
+
+TEST_CASE("Test OxTSRecording finds the packets in a recorded file.") {
+    std::vector<uint8_t> data{0x00, ncom::SYNC, 0x12, 0x34, 0x56};
+    data.insert(data.end(), SAMPLE.begin(), SAMPLE.end());
+    // Corrupted batch B and status channel: Only its sync byte remains plausible.
+    std::vector<uint8_t> corrupted{SAMPLE};
+    corrupted[30]++;
+    corrupted[65]++;
+    data.insert(data.end(), corrupted.begin(), corrupted.end());
+    data.insert(data.end(), SAMPLE.begin(), SAMPLE.end());
+    // Truncated tail as left by an interrupted recording.
+    data.insert(data.end(), SAMPLE.begin(), SAMPLE.begin() + 40);
+
+    char path[] = "/tmp/tests-oxts-XXXXXX";
+    const int FD{::mkstemp(path)};
+    REQUIRE(0 <= FD);
+    REQUIRE(static_cast<ssize_t>(data.size()) == ::write(FD, data.data(), data.size()));
+    ::close(FD);
+
+    {
+        OxTSRecording recording{path};
+        REQUIRE(recording.isOpen());
+        REQUIRE(data.size() == recording.size());
+        REQUIRE(std::equal(data.begin(), data.end(), recording.begin()));
+
+        const uint8_t *packet{OxTSRecording::findPacket(recording.begin(), recording.end())};
+        REQUIRE(recording.begin() + 5 == packet);
+        packet = OxTSRecording::findPacket(packet + ncom::PACKET_LENGTH, recording.end());
+        REQUIRE(recording.begin() + 5 + 2 * ncom::PACKET_LENGTH == packet);
+
+        OxTSDecoder decoder;
+        OxTSDecoder::Readings readings;
+        REQUIRE(decoder.decode(packet, ncom::PACKET_LENGTH, readings));
+        REQUIRE(0 != (readings.batches & OxTSDecoder::BATCH_B));
+        REQUIRE(recording.end() == OxTSRecording::findPacket(packet + ncom::PACKET_LENGTH, recording.end()));
+    }
+
+    REQUIRE(0 == ::truncate(path, 0));
+    {
+        OxTSRecording recording{path};
+        REQUIRE(recording.isOpen());
+        REQUIRE(0 == recording.size());
+        REQUIRE(recording.end() == OxTSRecording::findPacket(recording.begin(), recording.end()));
+    }
+    ::unlink(path);
+
+    OxTSRecording missing{"/nonexistent/recording.ncom"};
+    REQUIRE(!missing.isOpen());
+}
+
+TEST_CASE("Test OxTSBlackBox keeps the most recent packets across restarts.") {
+    char path[] = "/tmp/tests-oxts-XXXXXX";
+    const int FD{::mkstemp(path)};
+    REQUIRE(0 <= FD);
+    ::close(FD);
+
+    const std::chrono::system_clock::time_point START{std::chrono::seconds{1500000000}};
+    auto received = [&START](uint32_t i) { return START + std::chrono::milliseconds{10 * i}; };
+    auto sequences = [](const std::vector<const blackbox::Record *> &records) {
+        std::vector<uint32_t> retVal;
+        for (const auto *record : records) {
+            retVal.push_back(record->sequence);
+        }
+        return retVal;
+    };
+
+    {
+        OxTSBlackBox blackBox{path, 4};
+        REQUIRE(blackBox.isOpen());
+        for (uint32_t i{1}; i <= 3; i++) {
+            blackBox.record(i % 2, SAMPLE.data(), SAMPLE.size(), received(i));
+        }
+    }
+    {
+        OxTSRecording recording{path};
+        REQUIRE(blackbox::HEADER_SIZE + 4 * sizeof(blackbox::Record) == recording.size());
+        REQUIRE(OxTSBlackBox::isRingFile(recording.begin(), recording.size()));
+        const std::vector<const blackbox::Record *> RECORDS{OxTSBlackBox::chronological(recording.begin(), recording.size())};
+        REQUIRE((std::vector<uint32_t>{1, 2, 3} == sequences(RECORDS)));
+        REQUIRE(1 == RECORDS[0]->unit);
+        REQUIRE(0 == RECORDS[1]->unit);
+        REQUIRE(std::chrono::duration_cast<std::chrono::nanoseconds>(received(1).time_since_epoch()).count() == RECORDS[0]->received);
+        REQUIRE(SAMPLE.size() == RECORDS[0]->length);
+        REQUIRE(std::equal(SAMPLE.begin(), SAMPLE.end(), RECORDS[0]->packet.begin()));
+    }
+
+    // Restarting continues after the newest record and overwrites the oldest ones.
+    {
+        OxTSBlackBox blackBox{path, 4};
+        REQUIRE(blackBox.isOpen());
+        for (uint32_t i{4}; i <= 6; i++) {
+            blackBox.record(0, SAMPLE.data(), 10, received(i));
+        }
+    }
+    {
+        OxTSRecording recording{path};
+        const std::vector<const blackbox::Record *> RECORDS{OxTSBlackBox::chronological(recording.begin(), recording.size())};
+        REQUIRE((std::vector<uint32_t>{3, 4, 5, 6} == sequences(RECORDS)));
+        REQUIRE(10 == RECORDS[1]->length);
+        REQUIRE(0 == RECORDS[1]->packet[10]);
+    }
+
+    // A record torn by a crash while copying is skipped; the ring is continued after the one before.
+    {
+        OxTSBlackBox blackBox{path, 4};
+        blackBox.record(0, SAMPLE.data(), SAMPLE.size(), received(7));
+    }
+    {
+        const int RW{::open(path, O_RDWR)};
+        REQUIRE(0 <= RW);
+        const uint32_t TORN{0};
+        // Sequence 7 went into the third record.
+        REQUIRE(static_cast<ssize_t>(sizeof(TORN)) == ::pwrite(RW, &TORN, sizeof(TORN), static_cast<off_t>(blackbox::HEADER_SIZE + 2 * sizeof(blackbox::Record) + 8)));
+        ::close(RW);
+
+        OxTSRecording recording{path};
+        REQUIRE((std::vector<uint32_t>{4, 5, 6} == sequences(OxTSBlackBox::chronological(recording.begin(), recording.size()))));
+    }
+    {
+        OxTSBlackBox blackBox{path, 4};
+        blackBox.record(0, SAMPLE.data(), SAMPLE.size(), received(8));
+    }
+    {
+        OxTSRecording recording{path};
+        REQUIRE((std::vector<uint32_t>{4, 5, 6, 7} == sequences(OxTSBlackBox::chronological(recording.begin(), recording.size()))));
+    }
+
+    // A different capacity starts a new ring.
+    {
+        OxTSBlackBox blackBox{path, 2};
+        REQUIRE(blackBox.isOpen());
+    }
+    {
+        OxTSRecording recording{path};
+        REQUIRE(blackbox::HEADER_SIZE + 2 * sizeof(blackbox::Record) == recording.size());
+        REQUIRE(OxTSBlackBox::chronological(recording.begin(), recording.size()).empty());
+        REQUIRE(!OxTSBlackBox::isRingFile(SAMPLE.data(), SAMPLE.size()));
+    }
+    ::unlink(path);
+}
+
+TEST_CASE("Test OxTSConverter converts chunks in parallel like sequentially.") {
+    // A packet starting within the last packet of the first chunk that is not part of the sequential stream.
+    std::vector<uint8_t> data(10, 0x00);
+    data.insert(data.end(), SAMPLE.begin(), SAMPLE.end());
+    data[10 + ncom::StatusChannel::OFFSET] = ncom::SYNC;
+    std::vector<uint8_t> overlapping(data.end() - 10, data.end());
+    overlapping.insert(overlapping.end(), SAMPLE.begin() + 10, SAMPLE.end());
+    uint8_t sum{0};
+    for (std::size_t i{1}; i < ncom::Checksum2::OFFSET; i++) {
+        sum = static_cast<uint8_t>(sum + overlapping[i]);
+    }
+    overlapping[ncom::Checksum2::OFFSET] = sum;
+    data.insert(data.end(), overlapping.begin() + 10, overlapping.end());
+    REQUIRE(data.data() + 72 == OxTSRecording::findPacket(data.data() + 20, data.data() + data.size()));
+    for (uint32_t i{0}; i < 100; i++) {
+        data.insert(data.end(), SAMPLE.begin(), SAMPLE.end());
+    }
+    data.insert(data.end(), {0x01, ncom::SYNC, 0x02});
+
+    auto convert = [&data](OxTSConverter::Format format, uint32_t threads, std::size_t chunkSize, std::string &text) {
+        OxTSConverter converter{format, threads, chunkSize};
+        return converter.convert(data.data(), data.data() + data.size(), [&text](const char *d, std::size_t length) {
+            text.append(d, length);
+            return true;
+        });
+    };
+    std::string sequential;
+    const OxTSConverter::Summary SEQUENTIAL{convert(OxTSConverter::Format::CSV, 1, data.size(), sequential)};
+    REQUIRE(SEQUENTIAL.completed);
+    REQUIRE(101 == SEQUENTIAL.packets);
+    REQUIRE(0 == SEQUENTIAL.resynchronized);
+    REQUIRE(data.size() - 101 * ncom::PACKET_LENGTH == SEQUENTIAL.skipped);
+    REQUIRE(102 == std::count(sequential.begin(), sequential.end(), '\n'));
+    REQUIRE(0 == sequential.find("time,navigation,latitude,longitude,altitude,heading,"));
+
+    OxTSDecoder decoder;
+    OxTSDecoder::Readings readings;
+    REQUIRE(decoder.decode(SAMPLE.data(), SAMPLE.size(), readings));
+    std::array<char, 64> expected;
+    std::snprintf(expected.data(), expected.size(), "\n38300,4,%.9f,%.9f,", readings.position.latitude(), readings.position.longitude());
+    REQUIRE(std::string::npos != sequential.find(expected.data()));
+
+    // Chunks of one packet each, so that the second chunk synchronizes within the first packet.
+    for (uint32_t threads : {1u, 3u}) {
+        std::string parallel;
+        const OxTSConverter::Summary PARALLEL{convert(OxTSConverter::Format::CSV, threads, ncom::PACKET_LENGTH, parallel)};
+        REQUIRE(PARALLEL.completed);
+        REQUIRE(SEQUENTIAL.packets == PARALLEL.packets);
+        REQUIRE(1 == PARALLEL.resynchronized);
+        REQUIRE(sequential == parallel);
+    }
+
+    std::string json;
+    REQUIRE(101 == convert(OxTSConverter::Format::JSON, 2, 1000, json).packets);
+    REQUIRE(101 == std::count(json.begin(), json.end(), '\n'));
+    REQUIRE(0 == json.find("{\"time\":38300,\"navigation\":4,\"latitude\":"));
+
+    // Writing errors abort the conversion.
+    OxTSConverter converter{OxTSConverter::Format::JSON, 2, ncom::PACKET_LENGTH};
+    uint32_t writes{0};
+    const OxTSConverter::Summary ABORTED{converter.convert(data.data(), data.data() + data.size(), [&writes](const char *, std::size_t) {
+        return 3 > ++writes;
+    })};
+    REQUIRE(!ABORTED.completed);
+    REQUIRE(3 == writes);
+}
+
+TEST_CASE("Test OxTSFramer frames byte streams split at arbitrary positions.") {
+    // Garbage, 20 packets, a corrupted one, and 20 more packets with a false sync byte in between.
+    std::vector<uint8_t> stream{0x12, ncom::SYNC, 0x34};
+    for (uint32_t i{0}; i < 20; i++) {
+        stream.insert(stream.end(), SAMPLE.begin(), SAMPLE.end());
+    }
+    std::vector<uint8_t> corrupted{SAMPLE};
+    corrupted[40]++;
+    corrupted[65]++;
+    stream.insert(stream.end(), corrupted.begin(), corrupted.end());
+    stream.push_back(ncom::SYNC);
+    for (uint32_t i{0}; i < 20; i++) {
+        stream.insert(stream.end(), SAMPLE.begin(), SAMPLE.end());
+    }
+    const uint64_t SKIPPED{stream.size() - 40 * ncom::PACKET_LENGTH};
+
+    std::vector<const uint8_t *> frames;
+    bool allIntact{true};
+    OxTSFramer framer{[&frames, &allIntact](const uint8_t *frame, std::size_t length) {
+        frames.push_back(frame);
+        allIntact = allIntact && (ncom::PACKET_LENGTH == length) && std::equal(SAMPLE.begin(), SAMPLE.end(), frame);
+    }};
+
+    // One chunk: All frames are handed over in place.
+    framer.push(stream.data(), stream.size());
+    REQUIRE(allIntact);
+    REQUIRE(40 == frames.size());
+    REQUIRE(stream.data() + 3 == frames.front());
+    REQUIRE(40 == framer.statistics().frames);
+    REQUIRE(SKIPPED == framer.statistics().skipped);
+
+    // Chunks of every size, including single bytes.
+    for (std::size_t chunk : {std::size_t{1}, std::size_t{7}, std::size_t{71}, std::size_t{72}, std::size_t{73}, std::size_t{500}}) {
+        OxTSFramer f{[&frames, &allIntact](const uint8_t *frame, std::size_t length) {
+            frames.push_back(frame);
+            allIntact = allIntact && (ncom::PACKET_LENGTH == length) && std::equal(SAMPLE.begin(), SAMPLE.end(), frame);
+        }};
+        frames.clear();
+        for (std::size_t i{0}; i < stream.size(); i += chunk) {
+            f.push(stream.data() + i, std::min(chunk, stream.size() - i));
+        }
+        REQUIRE(allIntact);
+        REQUIRE(40 == frames.size());
+        REQUIRE(SKIPPED == f.statistics().skipped);
+    }
+
+    // A pseudo terminal stands in for a serial port.
+    const int MASTER{::posix_openpt(O_RDWR | O_NOCTTY)};
+    REQUIRE(0 <= MASTER);
+    REQUIRE(0 == ::grantpt(MASTER));
+    REQUIRE(0 == ::unlockpt(MASTER));
+    const int SLAVE{::open(::ptsname(MASTER), O_RDWR | O_NOCTTY)};
+    REQUIRE(0 <= SLAVE);
+    struct termios settings {};
+    REQUIRE(0 == ::tcgetattr(SLAVE, &settings));
+    ::cfmakeraw(&settings);
+    REQUIRE(0 == ::tcsetattr(SLAVE, TCSANOW, &settings));
+
+    OxTSFramer serial{[&frames, &allIntact](const uint8_t *frame, std::size_t length) {
+        frames.push_back(frame);
+        allIntact = allIntact && (ncom::PACKET_LENGTH == length) && std::equal(SAMPLE.begin(), SAMPLE.end(), frame);
+    }};
+    frames.clear();
+    std::array<uint8_t, 64> buffer;
+    std::size_t written{0};
+    while (40 > frames.size()) {
+        if (written < stream.size()) {
+            const ssize_t WRITTEN{::write(MASTER, stream.data() + written, std::min<std::size_t>(100, stream.size() - written))};
+            REQUIRE(0 < WRITTEN);
+            written += static_cast<std::size_t>(WRITTEN);
+        }
+        struct pollfd input {SLAVE, POLLIN, 0};
+        REQUIRE(1 == ::poll(&input, 1, 1000));
+        const ssize_t LENGTH{::read(SLAVE, buffer.data(), buffer.size())};
+        REQUIRE(0 < LENGTH);
+        serial.push(buffer.data(), static_cast<std::size_t>(LENGTH));
+    }
+    REQUIRE(allIntact);
+    REQUIRE(SKIPPED == serial.statistics().skipped);
+    ::close(SLAVE);
+    ::close(MASTER);
+}
+
+TEST_CASE("Test OxTSDecoder tracks the sequence of NCOM times.") {
+    using Sequence = OxTSDecoder::Sequence;
+    OxTSDecoder d{OxTSDecoder::Gating::NONE};
+    OxTSDecoder::Readings readings;
+    auto sequenceOf = [&d, &readings](uint16_t time) {
+        const std::vector<uint8_t> PACKET{samplePacketAt(time, 29, 0)};
+        REQUIRE(d.decode(PACKET.data(), PACKET.size(), readings));
+        return readings.sequence;
+    };
+
+    REQUIRE(Sequence::START == sequenceOf(0));
+    REQUIRE(Sequence::IN_ORDER == sequenceOf(10));
+    REQUIRE(Sequence::IN_ORDER == sequenceOf(20));
+    REQUIRE(Sequence::AFTER_GAP == sequenceOf(50));
+    REQUIRE(Sequence::REORDERED == sequenceOf(30));
+    REQUIRE(Sequence::DUPLICATE == sequenceOf(30));
+    REQUIRE(Sequence::DUPLICATE == sequenceOf(50));
+    REQUIRE(2 == d.statistics().missing.load());
+    REQUIRE(2 == d.statistics().duplicates.load());
+    REQUIRE(1 == d.statistics().reordered.load());
+
+    // Across the minute.
+    REQUIRE(Sequence::AFTER_GAP == sequenceOf(29990));
+    REQUIRE(Sequence::AFTER_GAP == sequenceOf(59980));
+    REQUIRE(Sequence::AFTER_GAP == sequenceOf(0));
+    REQUIRE(Sequence::REORDERED == sequenceOf(59990));
+    REQUIRE(Sequence::IN_ORDER == sequenceOf(10));
+    REQUIRE(2 == d.statistics().reordered.load());
+
+    // Packets too old to be told from a restarted unit, and invalid times, start anew.
+    REQUIRE(Sequence::START == sequenceOf(55010));
+    REQUIRE(Sequence::IN_ORDER == sequenceOf(55020));
+    REQUIRE(Sequence::START == sequenceOf(ncom::MILLISECONDS_PER_MINUTE));
+    REQUIRE(Sequence::IN_ORDER == sequenceOf(55030));
+
+    // Rejected packets are not tracked.
+    std::vector<uint8_t> corrupted{samplePacketAt(55040, 29, 0)};
+    corrupted[0] = 0xE6;
+    REQUIRE(!d.decode(corrupted.data(), corrupted.size(), readings));
+    REQUIRE(Sequence::START == readings.sequence);
+    REQUIRE(Sequence::IN_ORDER == sequenceOf(55040));
+
+    // At 250 Hz.
+    OxTSDecoder fast{OxTSDecoder::Gating::NONE, std::chrono::milliseconds{4}};
+    for (uint16_t time : {0, 4, 8, 16}) {
+        const std::vector<uint8_t> PACKET{samplePacketAt(time, 29, 0)};
+        REQUIRE(fast.decode(PACKET.data(), PACKET.size(), readings));
+    }
+    REQUIRE(Sequence::AFTER_GAP == readings.sequence);
+    REQUIRE(1 == fast.statistics().missing.load());
+}
+
+TEST_CASE("Test OxTSDecoder keeps the GPS minute of reordered packets.") {
+    constexpr uint32_t MINUTES{20000000};
+    OxTSDecoder d{OxTSDecoder::Gating::NONE};
+    OxTSDecoder::Readings readings;
+    std::vector<uint8_t> packet{samplePacketAt(59980, ncom::status::GPS_TIME_CHANNEL, MINUTES)};
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+
+    packet = samplePacketAt(0, 29, 0);
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE((std::chrono::minutes{MINUTES + 1}) == readings.gpsTime);
+
+    // A late packet of the previous minute, even if it carries the minute.
+    packet = samplePacketAt(59990, ncom::status::GPS_TIME_CHANNEL, MINUTES);
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE(OxTSDecoder::Sequence::REORDERED == readings.sequence);
+    REQUIRE((std::chrono::minutes{MINUTES} + std::chrono::milliseconds{59990}) == readings.gpsTime);
+
+    packet = samplePacketAt(10, 29, 0);
+    REQUIRE(d.decode(packet.data(), packet.size(), readings));
+    REQUIRE((std::chrono::minutes{MINUTES + 1} + std::chrono::milliseconds{10}) == readings.gpsTime);
+}
+
+TEST_CASE("Test OxTSReorderWindow releases packets in order.") {
+    std::vector<uint16_t> released;
+    std::vector<uint16_t> held;
+    auto collect = [&released, &held](const OxTSDecoder::Readings &readings, const std::chrono::system_clock::time_point &, bool isHeld) {
+        released.push_back(readings.time);
+        if (isHeld) {
+            held.push_back(readings.time);
+        }
+    };
+    auto push = [](OxTSReorderWindow &window, std::initializer_list<uint16_t> times) {
+        OxTSDecoder::Readings readings;
+        for (uint16_t time : times) {
+            readings.time = time;
+            window.push(readings, std::chrono::system_clock::time_point{});
+        }
+    };
+
+    OxTSReorderWindow window{3, OxTSDecoder::NOMINAL_PERIOD, collect};
+    push(window, {0, 10, 30});
+    REQUIRE((std::vector<uint16_t>{0, 10}) == released);
+    push(window, {20, 40, 40, 10});
+    REQUIRE((std::vector<uint16_t>{0, 10, 20, 30, 40}) == released);
+    REQUIRE((std::vector<uint16_t>{30}) == held);
+    REQUIRE(1 == window.statistics().held.load());
+    REQUIRE(2 == window.statistics().late.load());
+
+    // 60 is given up on once 90 no longer fits into the window; 80 is still awaited.
+    push(window, {50, 90, 70, 100});
+    REQUIRE((std::vector<uint16_t>{0, 10, 20, 30, 40, 50, 70}) == released);
+    push(window, {60});
+    REQUIRE(3 == window.statistics().late.load());
+    window.flush();
+    REQUIRE((std::vector<uint16_t>{0, 10, 20, 30, 40, 50, 70, 90, 100}) == released);
+    REQUIRE((std::vector<uint16_t>{30, 90, 100}) == held);
+    REQUIRE(3 == window.statistics().held.load());
+
+    // A stalled unit's held packets are released after depth periods.
+    released.clear();
+    held.clear();
+    using namespace std::literals::chrono_literals;
+    const std::chrono::system_clock::time_point START{std::chrono::system_clock::now()};
+    OxTSReorderWindow stalled{3, OxTSDecoder::NOMINAL_PERIOD, collect};
+    OxTSDecoder::Readings readings;
+    auto pushAt = [&stalled, &readings, START](uint16_t time) {
+        readings.time = time;
+        stalled.push(readings, START + std::chrono::milliseconds{time});
+    };
+    pushAt(0);
+    pushAt(20);
+    pushAt(30);
+    REQUIRE((std::vector<uint16_t>{0}) == released);
+    stalled.expire(START + 49ms);
+    REQUIRE((std::vector<uint16_t>{0}) == released);
+    // 30 follows 20 without a gap.
+    stalled.expire(START + 50ms);
+    REQUIRE((std::vector<uint16_t>{0, 20, 30}) == released);
+    // 60 follows 50 and is released with it although it was received later.
+    pushAt(50);
+    pushAt(60);
+    stalled.expire(START + 79ms);
+    REQUIRE((std::vector<uint16_t>{0, 20, 30}) == released);
+    stalled.expire(START + 80ms);
+    REQUIRE((std::vector<uint16_t>{0, 20, 30, 50, 60}) == released);
+    REQUIRE((std::vector<uint16_t>{20, 30, 50, 60}) == held);
+    REQUIRE(4 == stalled.statistics().held.load());
+    // Packets after the released ones follow in order.
+    pushAt(70);
+    REQUIRE((std::vector<uint16_t>{0, 20, 30, 50, 60, 70}) == released);
+    REQUIRE(0 == stalled.statistics().late.load());
+
+    // Across the minute and after the unit's time jumped back.
+    released.clear();
+    OxTSReorderWindow wrapping{3, OxTSDecoder::NOMINAL_PERIOD, collect};
+    push(wrapping, {59980, 59990, 10, 0, 20, 55000, 55010});
+    REQUIRE((std::vector<uint16_t>{59980, 59990, 0, 10, 20, 55000, 55010}) == released);
+
+    // Without depth, packets are released unchanged.
+    released.clear();
+    OxTSReorderWindow passthrough{0, OxTSDecoder::NOMINAL_PERIOD, collect};
+    push(passthrough, {0, 20, 10, 10});
+    REQUIRE((std::vector<uint16_t>{0, 20, 10, 10}) == released);
+}